@@ -19,6 +19,7 @@
 #include "collection_notifications.hpp"
 
 #include "impl/collection_notifier.hpp"
+#include "util/format.hpp"
 
 using namespace realm;
 using namespace realm::_impl;
@@ -54,3 +55,9 @@ NotificationToken& NotificationToken::operator=(realm::NotificationToken&& rgt)
     }
     return *this;
 }
+
+InvalidKeyPathException::InvalidKeyPathException(std::string const& object_type, std::string const& key_path)
+: std::logic_error(util::format("Key path '%1' does not refer to a property of '%2'", key_path, object_type))
+, object_type(object_type), key_path(key_path)
+{
+}
@@ -25,6 +25,9 @@
 #include <exception>
 #include <functional>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace realm {
@@ -83,6 +86,13 @@ struct CollectionChangeSet {
     // unreported moves which show up only as a delete/insert pair.
     std::vector<Move> moves;
 
+    // Per-column version of `modifications`, mapping a column index to the
+    // indices in the _old_ collection which were modified in that column. This
+    // is only populated for the changes to individual tables calculated while
+    // parsing the transaction log and for changes to single objects, as a
+    // collection's rows can be modified indirectly via links.
+    std::unordered_map<size_t, IndexSet> columns;
+
     bool empty() const
     {
         return deletions.empty() && insertions.empty() && modifications.empty()
@@ -90,6 +100,27 @@ struct CollectionChangeSet {
     }
 };
 
+// A hint for how urgently the changes for a notification callback are needed,
+// which the background worker uses to decide which notifiers to run first.
+// A notifier with multiple callbacks uses the most urgent of their priorities.
+enum class NotificationPriority : uint8_t {
+    // The collection is currently being displayed, so its changes should be
+    // delivered as soon as possible
+    Visible,
+    // The default priority
+    Background,
+    // The changes are not needed urgently, so other work should be done first
+    Idle,
+};
+
+// Thrown when a key path passed to add_notification_callback() does not name a
+// property of the collection's object type
+struct InvalidKeyPathException : public std::logic_error {
+    InvalidKeyPathException(std::string const& object_type, std::string const& key_path);
+    const std::string object_type;
+    const std::string key_path;
+};
+
 // A type-erasing wrapper for the callback for collection notifications. Can be
 // constructed with either any callable compatible with the signature
 // `void (CollectionChangeSet, std::exception_ptr)`, an object with member
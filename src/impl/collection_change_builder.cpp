@@ -58,8 +58,13 @@ void CollectionChangeBuilder::merge(CollectionChangeBuilder&& c)
                 return old.to == m.from;
             });
             if (it != c.moves.end()) {
-                if (modifications.contains(it->from))
+                if (modifications.contains(it->from)) {
                     c.modifications.add(it->to);
+                    for (auto& col : columns) {
+                        if (col.second.contains(it->from))
+                            c.columns[col.first].add(it->to);
+                    }
+                }
                 old.to = it->to;
                 *it = c.moves.back();
                 c.moves.pop_back();
@@ -92,6 +97,10 @@ void CollectionChangeBuilder::merge(CollectionChangeBuilder&& c)
         for (auto const& move : c.moves) {
             if (modifications.contains(move.from))
                 c.modifications.add(move.to);
+            for (auto& col : columns) {
+                if (col.second.contains(move.from))
+                    c.columns[col.first].add(move.to);
+            }
         }
     }
 
@@ -118,6 +127,13 @@ void CollectionChangeBuilder::merge(CollectionChangeBuilder&& c)
     modifications.shift_for_insert_at(c.insertions);
     modifications.add(c.modifications);
 
+    for (auto& col : columns) {
+        col.second.erase_at(c.deletions);
+        col.second.shift_for_insert_at(c.insertions);
+    }
+    for (auto const& col : c.columns)
+        columns[col.first].add(col.second);
+
     c = {};
     verify();
 }
@@ -154,14 +170,25 @@ void CollectionChangeBuilder::parse_complete()
               [](auto const& a, auto const& b) { return a.from < b.from; });
 }
 
-void CollectionChangeBuilder::modify(size_t ndx)
+void CollectionChangeBuilder::modify(size_t ndx, size_t col)
 {
     modifications.add(ndx);
+    if (col != IndexSet::npos)
+        columns[col].add(ndx);
 }
 
 void CollectionChangeBuilder::insert(size_t index, size_t count, bool track_moves)
 {
+    // Inserting after every index which has already been recorded (i.e.
+    // appending to a list) doesn't need to shift anything
+    if (track_moves && moves.empty() && modifications.ends_before(index) && insertions.ends_before(index)) {
+        insertions.append(index, count);
+        return;
+    }
+
     modifications.shift_for_insert_at(index, count);
+    for (auto& col : columns)
+        col.second.shift_for_insert_at(index, count);
     if (!track_moves)
         return;
 
@@ -176,6 +203,8 @@ void CollectionChangeBuilder::insert(size_t index, size_t count, bool track_move
 void CollectionChangeBuilder::erase(size_t index)
 {
     modifications.erase_at(index);
+    for (auto& col : columns)
+        col.second.erase_at(index);
     size_t unshifted = insertions.erase_or_unshift(index);
     if (unshifted != IndexSet::npos)
         deletions.add_shifted(unshifted);
@@ -201,6 +230,7 @@ void CollectionChangeBuilder::clear(size_t old_size)
     }
 
     modifications.clear();
+    columns.clear();
     insertions.clear();
     moves.clear();
     m_move_mapping.clear();
@@ -243,13 +273,18 @@ void CollectionChangeBuilder::move(size_t from, size_t to)
         }
     }
 
-    bool modified = modifications.contains(from);
-    modifications.erase_at(from);
+    auto move_modification = [&](IndexSet& indices) {
+        bool modified = indices.contains(from);
+        indices.erase_at(from);
 
-    if (modified)
-        modifications.insert_at(to);
-    else
-        modifications.shift_for_insert_at(to);
+        if (modified)
+            indices.insert_at(to);
+        else
+            indices.shift_for_insert_at(to);
+    };
+    move_modification(modifications);
+    for (auto& col : columns)
+        move_modification(col.second);
 }
 
 void CollectionChangeBuilder::move_over(size_t row_ndx, size_t last_row, bool track_moves)
@@ -266,16 +301,22 @@ void CollectionChangeBuilder::move_over(size_t row_ndx, size_t last_row, bool tr
             m_move_mapping.erase(row_ndx);
         }
         modifications.remove(row_ndx);
+        for (auto& col : columns)
+            col.second.remove(row_ndx);
         return;
     }
 
-    bool modified = modifications.contains(last_row);
-    if (modified) {
-        modifications.remove(last_row);
-        modifications.add(row_ndx);
-    }
-    else
-        modifications.remove(row_ndx);
+    auto move_modification = [&](IndexSet& indices) {
+        if (indices.contains(last_row)) {
+            indices.remove(last_row);
+            indices.add(row_ndx);
+        }
+        else
+            indices.remove(row_ndx);
+    };
+    move_modification(modifications);
+    for (auto& col : columns)
+        move_modification(col.second);
 
     if (!track_moves)
         return;
@@ -329,18 +370,23 @@ void CollectionChangeBuilder::swap(size_t ndx_1, size_t ndx_2, bool track_moves)
     if (ndx_1 > ndx_2)
         std::swap(ndx_1, ndx_2);
 
-    bool row_1_modified = modifications.contains(ndx_1);
-    bool row_2_modified = modifications.contains(ndx_2);
-    if (row_1_modified != row_2_modified) {
-        if (row_1_modified) {
-            modifications.remove(ndx_1);
-            modifications.add(ndx_2);
-        }
-        else {
-            modifications.remove(ndx_2);
-            modifications.add(ndx_1);
+    auto swap_modification = [&](IndexSet& indices) {
+        bool row_1_modified = indices.contains(ndx_1);
+        bool row_2_modified = indices.contains(ndx_2);
+        if (row_1_modified != row_2_modified) {
+            if (row_1_modified) {
+                indices.remove(ndx_1);
+                indices.add(ndx_2);
+            }
+            else {
+                indices.remove(ndx_2);
+                indices.add(ndx_1);
+            }
         }
-    }
+    };
+    swap_modification(modifications);
+    for (auto& col : columns)
+        swap_modification(col.second);
 
     if (!track_moves)
         return;
@@ -393,6 +439,10 @@ void CollectionChangeBuilder::subsume(size_t old_ndx, size_t new_ndx, bool track
     if (modifications.contains(old_ndx)) {
         modifications.add(new_ndx);
     }
+    for (auto& col : columns) {
+        if (col.second.contains(old_ndx))
+            col.second.add(new_ndx);
+    }
 
     if (!track_moves)
         return;
@@ -796,11 +846,21 @@ CollectionChangeSet CollectionChangeBuilder::finalize() &&
     // but we don't want inserts in the final modification set
     modifications.remove(insertions);
 
+    for (auto it = columns.begin(); it != columns.end(); ) {
+        it->second.erase_at(insertions);
+        it->second.shift_for_insert_at(deletions);
+        if (it->second.empty())
+            it = columns.erase(it);
+        else
+            ++it;
+    }
+
     return {
         std::move(deletions),
         std::move(insertions),
         std::move(modifications_in_old),
         std::move(modifications),
-        std::move(moves)
+        std::move(moves),
+        std::move(columns)
     };
 }
@@ -19,9 +19,12 @@
 #include "impl/collection_notifier.hpp"
 
 #include "impl/realm_coordinator.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
 #include "shared_realm.hpp"
 
 #include <realm/link_view.hpp>
+#include <realm/util/scope_exit.hpp>
 
 using namespace realm;
 using namespace realm::_impl;
@@ -30,18 +33,23 @@ std::function<bool (size_t)>
 CollectionNotifier::get_modification_checker(TransactionChangeInfo const& info,
                                              Table const& root_table)
 {
-    // First check if any of the tables accessible from the root table were
+    if (!any_related_table_was_modified(info)) {
+        return [](size_t) { return false; };
+    }
+
+    return DeepChangeChecker(info, root_table, m_related_tables, callback_columns());
+}
+
+bool CollectionNotifier::any_related_table_was_modified(TransactionChangeInfo const& info) const noexcept
+{
+    // Check if any of the tables accessible from the root table were
     // actually modified. This can be false if there were only insertions, or
     // deletions which were not linked to by any row in the linking table
     auto table_modified = [&](auto& tbl) {
         return tbl.table_ndx < info.tables.size()
             && !info.tables[tbl.table_ndx].modifications.empty();
     };
-    if (!any_of(begin(m_related_tables), end(m_related_tables), table_modified)) {
-        return [](size_t) { return false; };
-    }
-
-    return DeepChangeChecker(info, root_table, m_related_tables);
+    return any_of(begin(m_related_tables), end(m_related_tables), table_modified);
 }
 
 void DeepChangeChecker::find_related_tables(std::vector<RelatedTable>& out, Table const& table)
@@ -68,12 +76,14 @@ void DeepChangeChecker::find_related_tables(std::vector<RelatedTable>& out, Tabl
 
 DeepChangeChecker::DeepChangeChecker(TransactionChangeInfo const& info,
                                      Table const& root_table,
-                                     std::vector<RelatedTable> const& related_tables)
+                                     std::vector<RelatedTable> const& related_tables,
+                                     std::vector<size_t> root_columns)
 : m_info(info)
 , m_root_table(root_table)
 , m_root_table_ndx(root_table.get_index_in_group())
 , m_root_modifications(m_root_table_ndx < info.tables.size() ? &info.tables[m_root_table_ndx].modifications : nullptr)
 , m_related_tables(related_tables)
+, m_root_columns(std::move(root_columns))
 {
 }
 
@@ -98,6 +108,10 @@ bool DeepChangeChecker::check_outgoing_links(size_t table_ndx,
     };
 
     for (auto const& link : it->links) {
+        // Only follow the links from the root object which are being observed
+        if (depth == 0 && !m_root_columns.empty()
+            && !std::binary_search(begin(m_root_columns), end(m_root_columns), link.col_ndx))
+            continue;
         if (already_checking(link.col_ndx))
             continue;
         if (!link.is_list) {
@@ -147,8 +161,16 @@ bool DeepChangeChecker::check_row(Table const& table, size_t idx, size_t depth)
 
 bool DeepChangeChecker::operator()(size_t ndx)
 {
-    if (m_root_modifications && m_root_modifications->contains(ndx))
-        return true;
+    if (m_root_modifications && m_root_modifications->contains(ndx)) {
+        if (m_root_columns.empty())
+            return true;
+        auto const& columns = m_info.tables[m_root_table_ndx].columns;
+        for (auto col : m_root_columns) {
+            auto it = columns.find(col);
+            if (it != columns.end() && it->second.contains(ndx))
+                return true;
+        }
+    }
     return check_row(m_root_table, ndx, 0);
 }
 
@@ -165,55 +187,150 @@ CollectionNotifier::~CollectionNotifier()
     unregister();
 }
 
-size_t CollectionNotifier::add_callback(CollectionChangeCallback callback)
+size_t CollectionNotifier::add_callback(CollectionChangeCallback callback, std::vector<size_t> columns,
+                                        NotificationPriority priority)
 {
     m_realm->verify_thread();
 
-    auto next_token = [=] {
-        size_t token = 0;
-        for (auto& callback : m_callbacks) {
-            if (token <= callback.token) {
-                token = callback.token + 1;
-            }
-        }
+    size_t token;
+    bool had_callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_callback_mutex);
+        token = m_next_token++;
+
+        auto old_callbacks = m_callbacks.load();
+        auto callbacks = old_callbacks ? std::make_shared<CallbackList>(*old_callbacks) : std::make_shared<CallbackList>();
+        had_callbacks = !callbacks->empty();
+        callbacks->push_back(std::make_shared<Callback>(std::move(callback), token, std::move(columns), priority));
+        update_priority(*callbacks);
+        m_callbacks.store(std::move(callbacks));
+        m_have_callbacks = true;
+    }
+
+    // Don't need to wake up if we're already sending notifications, as the
+    // new callback will be called by the in-progress delivery
+    if (m_delivering)
         return token;
-    };
 
-    std::lock_guard<std::mutex> lock(m_callback_mutex);
-    auto token = next_token();
-    m_callbacks.push_back({std::move(callback), token, false});
-    if (m_callback_index == npos) { // Don't need to wake up if we're already sending notifications
-        Realm::Internal::get_coordinator(*m_realm).send_commit_notifications();
-        m_have_callbacks = true;
+    auto& coordinator = Realm::Internal::get_coordinator(*m_realm);
+    if (had_callbacks) {
+        // The background work for this notifier is already being done, so
+        // only the Realm which the callback was added to needs to be woken
+        // up to deliver the initial notification
+        coordinator.notify_realm(*m_realm);
+    }
+    else {
+        // The notifier may have skipped its work while it had no callbacks,
+        // so the worker needs to run it again
+        coordinator.send_commit_notifications();
     }
     return token;
 }
 
 void CollectionNotifier::remove_callback(size_t token)
 {
-    Callback old;
+    // Destroy the old list after releasing the lock, as doing so may destroy
+    // the callback being removed
+    std::shared_ptr<const CallbackList> old_callbacks;
     {
         std::lock_guard<std::mutex> lock(m_callback_mutex);
-        REALM_ASSERT(m_error || m_callbacks.size() > 0);
+        old_callbacks = m_callbacks.load();
+        REALM_ASSERT(m_error || (old_callbacks && old_callbacks->size() > 0));
+        if (!old_callbacks)
+            return;
 
-        auto it = find_if(begin(m_callbacks), end(m_callbacks),
-                          [=](const auto& c) { return c.token == token; });
+        auto it = lower_bound(begin(*old_callbacks), end(*old_callbacks), token,
+                              [](auto const& c, size_t t) { return c->token < t; });
         // We should only fail to find the callback if it was removed due to an error
-        REALM_ASSERT(m_error || it != end(m_callbacks));
-        if (it == end(m_callbacks)) {
+        bool found = it != end(*old_callbacks) && (*it)->token == token;
+        REALM_ASSERT(m_error || found);
+        if (!found) {
             return;
         }
 
-        size_t idx = distance(begin(m_callbacks), it);
-        if (m_callback_index != npos && m_callback_index >= idx) {
-            --m_callback_index;
+        (*it)->removed = true;
+
+        auto callbacks = std::make_shared<CallbackList>();
+        callbacks->reserve(old_callbacks->size() - 1);
+        callbacks->insert(callbacks->end(), begin(*old_callbacks), it);
+        callbacks->insert(callbacks->end(), it + 1, end(*old_callbacks));
+
+        m_have_callbacks = !callbacks->empty();
+        update_priority(*callbacks);
+        m_callbacks.store(std::move(callbacks));
+    }
+}
+
+void CollectionNotifier::update_priority(CallbackList const& callbacks) noexcept
+{
+    auto priority = NotificationPriority::Idle;
+    for (auto const& callback : callbacks)
+        priority = std::min(priority, callback->priority);
+    m_priority = priority;
+}
+
+template<typename Fn>
+void CollectionNotifier::for_each_callback(Fn&& fn)
+{
+    bool was_delivering = m_delivering;
+    m_delivering = true;
+    auto reset_delivering = util::make_scope_exit([&]() noexcept { m_delivering = was_delivering; });
+
+    // Iterate over a snapshot of the callback list. If a callback adds or
+    // removes callbacks the list is replaced rather than modified, so after
+    // reaching the end of the snapshot check for a newer list and continue
+    // from the first callback with a token after the last one called.
+    // Removed callbacks are flagged so that they're skipped even if they're in
+    // the snapshot being iterated.
+    size_t next_token = 0;
+    for (auto callbacks = m_callbacks.load(); callbacks; ) {
+        auto it = lower_bound(begin(*callbacks), end(*callbacks), next_token,
+                              [](auto const& c, size_t t) { return c->token < t; });
+        for (; it != end(*callbacks); ++it) {
+            auto& callback = **it;
+            next_token = callback.token + 1;
+            if (!callback.removed)
+                fn(callback);
         }
 
-        old = std::move(*it);
-        m_callbacks.erase(it);
+        auto current = m_callbacks.load();
+        if (current == callbacks)
+            break;
+        callbacks = std::move(current);
+    }
+}
 
-        m_have_callbacks = !m_callbacks.empty();
+std::vector<size_t> CollectionNotifier::callback_columns() const
+{
+    std::vector<size_t> columns;
+    auto callbacks = m_callbacks.load();
+    if (!callbacks)
+        return columns;
+
+    for (auto const& callback : *callbacks) {
+        if (callback->columns.empty())
+            return {};
+        columns.insert(columns.end(), begin(callback->columns), end(callback->columns));
     }
+    std::sort(begin(columns), end(columns));
+    columns.erase(std::unique(begin(columns), end(columns)), end(columns));
+    return columns;
+}
+
+std::vector<size_t> CollectionNotifier::columns_for_key_paths(ObjectSchema const& object_schema,
+                                                              std::vector<std::string> const& key_paths)
+{
+    std::vector<size_t> columns;
+    columns.reserve(key_paths.size());
+    for (auto const& key_path : key_paths) {
+        auto property = object_schema.property_for_name(key_path.substr(0, key_path.find('.')));
+        if (!property)
+            throw InvalidKeyPathException(object_schema.name, key_path);
+        columns.push_back(property->table_column);
+    }
+    std::sort(begin(columns), end(columns));
+    columns.erase(std::unique(begin(columns), end(columns)), end(columns));
+    return columns;
 }
 
 void CollectionNotifier::unregister() noexcept
@@ -222,6 +339,12 @@ void CollectionNotifier::unregister() noexcept
     m_realm = nullptr;
 }
 
+bool CollectionNotifier::is_for_realm(Realm& realm) const noexcept
+{
+    std::lock_guard<std::mutex> lock(m_realm_mutex);
+    return m_realm.get() == &realm;
+}
+
 bool CollectionNotifier::is_alive() const noexcept
 {
     std::lock_guard<std::mutex> lock(m_realm_mutex);
@@ -264,37 +387,44 @@ void CollectionNotifier::prepare_handover()
 
 void CollectionNotifier::before_advance()
 {
-    while (auto fn = next_callback(!m_changes_to_deliver.empty(), true))
-        fn.before(m_changes_to_deliver);
+    bool has_changes = !m_changes_to_deliver.empty();
+    for_each_callback([&](Callback& callback) {
+        if (has_changes || !callback.initial_delivered)
+            callback.fn.before(m_changes_to_deliver);
+    });
 }
 
 void CollectionNotifier::after_advance()
 {
-    while (auto fn = next_callback(!m_changes_to_deliver.empty(), false))
-        fn.after(m_changes_to_deliver);
+    bool has_changes = !m_changes_to_deliver.empty();
+    for_each_callback([&](Callback& callback) {
+        if (callback.initial_delivered && !has_changes)
+            return;
+        callback.initial_delivered = true;
+        callback.fn.after(m_changes_to_deliver);
+    });
     m_changes_to_deliver = {};
 }
 
 void CollectionNotifier::deliver_error(std::exception_ptr error)
 {
-    while (auto fn = next_callback(true, false)) {
-        fn.error(error);
-    }
+    for_each_callback([&](Callback& callback) {
+        callback.fn.error(error);
+    });
 
     // Remove all the callbacks as we never need to call anything ever again
     // after delivering an error
+    std::shared_ptr<const CallbackList> old_callbacks;
     std::lock_guard<std::mutex> callback_lock(m_callback_mutex);
-    m_callbacks.clear();
+    old_callbacks = m_callbacks.exchange(nullptr);
+    m_have_callbacks = false;
     m_error = true;
 }
 
 SharedGroup::VersionID CollectionNotifier::package_for_delivery(Realm& realm)
 {
-    {
-        std::lock_guard<std::mutex> lock(m_realm_mutex);
-        if (m_realm.get() != &realm) {
-            return SharedGroup::VersionID{};
-        }
+    if (!is_for_realm(realm)) {
+        return SharedGroup::VersionID{};
     }
 
     if (!prepare_to_deliver()) {
@@ -304,24 +434,6 @@ SharedGroup::VersionID CollectionNotifier::package_for_delivery(Realm& realm)
     return version();
 }
 
-CollectionChangeCallback CollectionNotifier::next_callback(bool has_changes, bool pre)
-{
-    std::lock_guard<std::mutex> callback_lock(m_callback_mutex);
-
-    for (++m_callback_index; m_callback_index < m_callbacks.size(); ++m_callback_index) {
-        auto& callback = m_callbacks[m_callback_index];
-        if (callback.initial_delivered && !has_changes) {
-            continue;
-        }
-        if (!pre)
-            callback.initial_delivered = true;
-        return callback.fn;
-    }
-
-    m_callback_index = npos;
-    return nullptr;
-}
-
 void CollectionNotifier::attach_to(SharedGroup& sg)
 {
     REALM_ASSERT(!m_sg);
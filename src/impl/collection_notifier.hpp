@@ -20,17 +20,21 @@
 #define REALM_BACKGROUND_COLLECTION_HPP
 
 #include "impl/collection_change_builder.hpp"
+#include "util/atomic_shared_ptr.hpp"
 
 #include <realm/group_shared.hpp>
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <exception>
 #include <functional>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 
 namespace realm {
+class ObjectSchema;
 class Realm;
 
 namespace _impl {
@@ -59,8 +63,12 @@ public:
         std::vector<OutgoingLink> links;
     };
 
+    // If `root_columns` is non-empty, only modifications to those columns of
+    // the root table's rows (or to the objects linked to via those columns)
+    // are considered changes
     DeepChangeChecker(TransactionChangeInfo const& info, Table const& root_table,
-                      std::vector<RelatedTable> const& related_tables);
+                      std::vector<RelatedTable> const& related_tables,
+                      std::vector<size_t> root_columns = {});
 
     bool operator()(size_t row_ndx);
 
@@ -75,6 +83,7 @@ private:
     IndexSet const* const m_root_modifications;
     std::vector<IndexSet> m_not_modified;
     std::vector<RelatedTable> const& m_related_tables;
+    const std::vector<size_t> m_root_columns;
 
     struct Path {
         size_t table;
@@ -108,8 +117,12 @@ public:
 
     // Add a callback to be called each time the collection changes
     // This can only be called from the target collection's thread
+    // If `columns` is non-empty, the callback is only interested in changes
+    // to those columns of the collection's table, which lets the notifier skip
+    // checking for other changes if every callback is filtered
     // Returns a token which can be passed to remove_callback()
-    size_t add_callback(CollectionChangeCallback callback);
+    size_t add_callback(CollectionChangeCallback callback, std::vector<size_t> columns = {},
+                        NotificationPriority priority = NotificationPriority::Background);
     // Remove a previously added token. The token is no longer valid after
     // calling this function and must not be used again. This function can be
     // called from any thread.
@@ -119,6 +132,7 @@ public:
     // API for RealmCoordinator to manage running things and calling callbacks
 
     Realm* get_realm() const noexcept { return m_realm.get(); }
+    bool is_for_realm(Realm&) const noexcept;
 
     // Get the SharedGroup version which this collection can attach to (if it's
     // in handover mode), or can deliver to (if it's been handed over to the BG worker alredad)
@@ -149,6 +163,23 @@ public:
 
     bool is_alive() const noexcept;
 
+    // The most urgent priority of the registered callbacks, or Idle if there
+    // are none
+    NotificationPriority priority() const noexcept { return m_priority; }
+
+    // How long run() took the last time it was called, used by the worker to
+    // run quick notifiers before slow ones. Only used on the worker thread.
+    std::chrono::steady_clock::duration last_run_duration() const noexcept { return m_last_run_duration; }
+    void set_last_run_duration(std::chrono::steady_clock::duration d) noexcept { m_last_run_duration = d; }
+
+    // Get the sorted column indices for the given key paths, throwing
+    // InvalidKeyPathException if any of them do not name a property of the
+    // given object type. Only the first component of each key path is used,
+    // as any change to an object linked via a property is reported as a
+    // change to that property.
+    static std::vector<size_t> columns_for_key_paths(ObjectSchema const& object_schema,
+                                                     std::vector<std::string> const& key_paths);
+
     // Attach the handed-over query to `sg`. Must not be already attached to a SharedGroup.
     void attach_to(SharedGroup& sg);
     // Create a new query handover object and stop using the previously attached
@@ -172,6 +203,14 @@ protected:
     std::unique_lock<std::mutex> lock_target();
 
     std::function<bool (size_t)> get_modification_checker(TransactionChangeInfo const&, Table const&);
+    // Were any rows in the tables which the checker looks at modified? If not
+    // there's no need to check each row at all
+    bool any_related_table_was_modified(TransactionChangeInfo const&) const noexcept;
+    std::vector<DeepChangeChecker::RelatedTable> const& related_tables() const noexcept { return m_related_tables; }
+
+    // The union of the columns which the callbacks are filtered to, or empty
+    // if any callback wants changes to all columns
+    std::vector<size_t> callback_columns() const;
 
 private:
     virtual void do_attach_to(SharedGroup&) = 0;
@@ -191,17 +230,36 @@ private:
     CollectionChangeSet m_changes_to_deliver;
 
     std::vector<DeepChangeChecker::RelatedTable> m_related_tables;
+    std::chrono::steady_clock::duration m_last_run_duration{};
 
     struct Callback {
+        Callback(CollectionChangeCallback fn, size_t token, std::vector<size_t> columns,
+                 NotificationPriority priority)
+        : fn(std::move(fn)), token(token), columns(std::move(columns)), priority(priority) { }
+
         CollectionChangeCallback fn;
         size_t token;
-        bool initial_delivered;
+        // Sorted columns the callback is filtered to, or empty for all columns
+        std::vector<size_t> columns;
+        NotificationPriority priority;
+        // Only read or written on the target thread
+        bool initial_delivered = false;
+        // Set by remove_callback() so that a snapshot of the callback list
+        // which is currently being delivered to skips the removed callback
+        std::atomic<bool> removed = {false};
     };
-
-    // Currently registered callbacks and a mutex which must always be held
-    // while doing anything with them or m_callback_index
+    // Sorted by token, as tokens are handed out in increasing order and new
+    // callbacks are always appended
+    using CallbackList = std::vector<std::shared_ptr<Callback>>;
+
+    // The currently registered callbacks. The list is never modified once it
+    // has been published; adding or removing a callback copies it and
+    // atomically replaces the pointer, so delivering notifications only needs
+    // to load the pointer and not lock anything. m_callback_mutex serializes
+    // the writers and guards m_next_token.
     std::mutex m_callback_mutex;
-    std::vector<Callback> m_callbacks;
+    util::AtomicSharedPtr<const CallbackList> m_callbacks;
+    size_t m_next_token = 0;
 
     // Cached value for if m_callbacks is empty, needed to avoid deadlocks in
     // run() due to lock-order inversion between m_callback_mutex and m_target_mutex
@@ -209,11 +267,18 @@ private:
     // some extra work.
     std::atomic<bool> m_have_callbacks = {false};
 
-    // Iteration variable for looping over callbacks
-    // remove_callback() updates this when needed
-    size_t m_callback_index = npos;
+    // Cached priority of the current callbacks, read by the worker thread to
+    // order the notifiers. A stale value only affects the order they run in.
+    std::atomic<NotificationPriority> m_priority = {NotificationPriority::Idle};
+    void update_priority(CallbackList const& callbacks) noexcept;
+
+    // Set while callbacks are being called on the target thread. Callbacks
+    // added from within a callback are picked up by the in-progress delivery
+    // rather than requiring another wakeup.
+    bool m_delivering = false;
 
-    CollectionChangeCallback next_callback(bool has_changes, bool pre);
+    template<typename Fn>
+    void for_each_callback(Fn&& fn);
 };
 
 // A smart pointer to a CollectionNotifier that unregisters the notifier when
@@ -25,7 +25,8 @@ AnyHandover::AnyHandover(AnyHandover&& handover)
 {
     switch (handover.m_type) {
         case AnyThreadConfined::Type::Object:
-            new (&m_object.row_handover) RowHandover(std::move(handover.m_object.row_handover));
+            m_object.table_ndx = handover.m_object.table_ndx;
+            m_object.row_ndx = handover.m_object.row_ndx;
             new (&m_object.object_schema_name) std::string(std::move(handover.m_object.object_schema_name));
             break;
 
@@ -52,7 +53,7 @@ AnyHandover::~AnyHandover()
 {
     switch (m_type) {
         case AnyThreadConfined::Type::Object:
-            m_object.row_handover.~unique_ptr();
+            m_object.object_schema_name.~basic_string();
             break;
 
         case AnyThreadConfined::Type::List:
@@ -71,10 +72,15 @@ AnyThreadConfined AnyHandover::import_from_handover(SharedRealm realm) &&
     SharedGroup& shared_group = Realm::Internal::get_shared_group(*realm);
     switch (m_type) {
         case AnyThreadConfined::Type::Object: {
-            auto row = shared_group.import_from_handover(std::move(m_object.row_handover));
-            auto object_schema = realm->schema().find(m_object.object_schema_name);
-            REALM_ASSERT_DEBUG(object_schema != realm->schema().end());
-            return AnyThreadConfined(Object(std::move(realm), *object_schema, std::move(*row)));
+            if (m_object.table_ndx == npos) {
+                auto object_schema = realm->find_object_schema(m_object.object_schema_name);
+                REALM_ASSERT_DEBUG(object_schema);
+                return AnyThreadConfined(Object(std::move(realm), *object_schema, Row()));
+            }
+            TableRef table = realm->read_group().get_table(m_object.table_ndx);
+            auto object_schema = realm->find_object_schema(ObjectStore::object_type_for_table_name(table->get_name()));
+            REALM_ASSERT_DEBUG(object_schema);
+            return AnyThreadConfined(Object(std::move(realm), *object_schema, table->get(m_object.row_ndx)));
         }
         case AnyThreadConfined::Type::List: {
             auto link_view_ref = shared_group.import_linkview_from_handover(std::move(m_list.link_view_handover));
@@ -48,14 +48,19 @@ public:
 private:
     friend AnyThreadConfined;
 
-    using RowHandover      = std::unique_ptr<SharedGroup::Handover<Row>>;
     using QueryHandover    = std::unique_ptr<SharedGroup::Handover<Query>>;
     using LinkViewHandover = std::unique_ptr<SharedGroup::Handover<LinkView>>;
 
     AnyThreadConfined::Type m_type;
     union {
+        // Objects are handed over as the position of their row rather than
+        // with SharedGroup::export_for_handover(), as that requires several
+        // heap allocations per object, and the position is all that's needed
+        // to import a row at the same version. The object type is derived from
+        // the table at import time, so it is only stored for detached rows.
         struct {
-            RowHandover row_handover;
+            size_t table_ndx;
+            size_t row_ndx;
             std::string object_schema_name;
         } m_object;
 
@@ -69,8 +74,8 @@ private:
         } m_results;
     };
 
-    AnyHandover(RowHandover row_handover, std::string object_schema_name)
-    : m_type(AnyThreadConfined::Type::Object), m_object({std::move(row_handover), std::move(object_schema_name)}) {}
+    AnyHandover(size_t table_ndx, size_t row_ndx, std::string object_schema_name)
+    : m_type(AnyThreadConfined::Type::Object), m_object({table_ndx, row_ndx, std::move(object_schema_name)}) {}
 
     AnyHandover(LinkViewHandover link_view)
     : m_type(AnyThreadConfined::Type::List), m_list({std::move(link_view)}) {}
@@ -95,6 +95,15 @@ void ListNotifier::run()
         return;
     }
 
+    // If none of the rows which the list could link to (directly or
+    // indirectly) were modified, then the only changes are the ones made to
+    // the list itself, which were already recorded while parsing the
+    // transaction log. This makes appending to a large list O(1) here.
+    if (!any_related_table_was_modified(*m_info)) {
+        m_prev_size = m_lv->size();
+        return;
+    }
+
     auto row_did_change = get_modification_checker(*m_info, m_lv->get_target_table());
     for (size_t i = 0; i < m_lv->size(); ++i) {
         if (m_change.modifications.contains(i))
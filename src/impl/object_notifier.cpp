@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "impl/object_notifier.hpp"
+
+#include "shared_realm.hpp"
+
+#include <realm/table.hpp>
+
+#include <algorithm>
+
+using namespace realm;
+using namespace realm::_impl;
+
+ObjectNotifier::ObjectNotifier(Row const& row, std::shared_ptr<Realm> realm)
+: CollectionNotifier(std::move(realm))
+{
+    set_table(*row.get_table());
+
+    auto& sg = Realm::Internal::get_shared_group(*get_realm());
+    m_row_handover = sg.export_for_handover(row);
+}
+
+void ObjectNotifier::release_data() noexcept
+{
+    m_row = {};
+}
+
+void ObjectNotifier::do_attach_to(SharedGroup& sg)
+{
+    REALM_ASSERT(!m_row.is_attached());
+    // There's nothing to import if the row was deleted while the notifier was
+    // being advanced to the latest version, as detached rows aren't exported
+    if (m_row_handover)
+        m_row = std::move(*sg.import_from_handover(std::move(m_row_handover)));
+}
+
+void ObjectNotifier::do_detach_from(SharedGroup& sg)
+{
+    REALM_ASSERT(!m_row_handover);
+    if (m_row.is_attached()) {
+        m_row_handover = sg.export_for_handover(m_row);
+        m_row = {};
+    }
+}
+
+bool ObjectNotifier::do_add_required_change_info(TransactionChangeInfo& info)
+{
+    REALM_ASSERT(!m_row_handover);
+    if (!m_row.is_attached()) {
+        return false; // row was deleted before the last run
+    }
+
+    m_info = &info;
+    return true;
+}
+
+void ObjectNotifier::run()
+{
+    if (!m_row.is_attached()) {
+        // Report the deletion only on the first run after it happened
+        if (!m_deletion_reported) {
+            m_change = {};
+            m_change.deletions.add(0);
+            m_deletion_reported = true;
+        }
+        else {
+            m_change = {};
+        }
+        return;
+    }
+
+    if (!m_info || !any_related_table_was_modified(*m_info)) {
+        return;
+    }
+
+    auto columns = callback_columns();
+    auto wanted = [&](size_t col) {
+        return columns.empty() || std::binary_search(begin(columns), end(columns), col);
+    };
+
+    auto& table = *m_row.get_table();
+    size_t table_ndx = table.get_index_in_group();
+    size_t row_ndx = m_row.get_index();
+
+    // The table changes are still in terms of the new row indices, so they
+    // can be checked against the row accessor's current position directly
+    if (table_ndx < m_info->tables.size()) {
+        for (auto const& col : m_info->tables[table_ndx].columns) {
+            if (wanted(col.first) && col.second.contains(row_ndx))
+                m_change.modify(0, col.first);
+        }
+    }
+
+    for (size_t col = 0, count = table.get_column_count(); col < count; ++col) {
+        auto type = table.get_column_type(col);
+        if ((type != type_Link && type != type_LinkList) || !wanted(col) || m_change.columns.count(col))
+            continue;
+        if (DeepChangeChecker(*m_info, table, related_tables(), {col})(row_ndx))
+            m_change.modify(0, col);
+    }
+}
+
+void ObjectNotifier::do_prepare_handover(SharedGroup&)
+{
+    add_changes(std::move(m_change));
+}
@@ -25,39 +25,184 @@
 #include "object_schema.hpp"
 #include "object_store.hpp"
 #include "schema.hpp"
+#include "util/atomic_shared_ptr.hpp"
 
 #include <realm/group_shared.hpp>
 #include <realm/lang_bind_helper.hpp>
+#include <realm/util/file.hpp>
 #include <realm/string_data.hpp>
 
 #include <unordered_map>
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <numeric>
+#include <thread>
 
 using namespace realm;
 using namespace realm::_impl;
 
-static std::mutex s_coordinator_mutex;
-static std::unordered_map<std::string, std::weak_ptr<RealmCoordinator>> s_coordinators_per_path;
+namespace {
+using CoordinatorMap = std::unordered_map<std::string, std::weak_ptr<RealmCoordinator>>;
+
+// Coordinators are looked up far more often than they're created, so each
+// shard publishes an immutable map which lookups load without taking the
+// shard's mutex, and which is only replaced (under that mutex) when entries
+// are added or removed. Loading the snapshot is only as cheap as the
+// standard library's atomic shared_ptr operations, which may themselves
+// briefly take an internal lock, but lookups never wait for a copy of the
+// map to be made.
+struct CoordinatorShard {
+    std::mutex mutex;
+    util::AtomicSharedPtr<const CoordinatorMap> coordinators{std::make_shared<const CoordinatorMap>()};
+};
 
-std::shared_ptr<RealmCoordinator> RealmCoordinator::get_coordinator(StringData path)
+const size_t shard_count = 16;
+std::array<CoordinatorShard, shard_count> s_coordinator_shards;
+
+CoordinatorShard& shard_for_path(std::string const& path)
 {
-    std::lock_guard<std::mutex> lock(s_coordinator_mutex);
+    return s_coordinator_shards[std::hash<std::string>()(path) % shard_count];
+}
+
+std::shared_ptr<RealmCoordinator> find_coordinator(CoordinatorMap const& coordinators, std::string const& path)
+{
+    auto it = coordinators.find(path);
+    return it == coordinators.end() ? nullptr : it->second.lock();
+}
 
-    auto& weak_coordinator = s_coordinators_per_path[path];
-    if (auto coordinator = weak_coordinator.lock()) {
+std::shared_ptr<CoordinatorMap> copy_live_coordinators(CoordinatorMap const& coordinators, size_t extra_capacity)
+{
+    auto copy = std::make_shared<CoordinatorMap>();
+    copy->reserve(coordinators.size() + extra_capacity);
+    for (auto& entry : coordinators) {
+        if (!entry.second.expired()) {
+            copy->insert(entry);
+        }
+    }
+    return copy;
+}
+
+// Drop the entries for destroyed coordinators from every shard which has
+// any, and return whether the registry is now empty
+bool sweep_expired_coordinators()
+{
+    bool empty = true;
+    for (auto& shard : s_coordinator_shards) {
+        auto current = shard.coordinators.load();
+        bool has_expired = std::any_of(current->begin(), current->end(),
+                                       [](auto& entry) { return entry.second.expired(); });
+        if (has_expired) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            current = copy_live_coordinators(*shard.coordinators.load(), 0);
+            shard.coordinators.store(current);
+        }
+        empty = empty && current->empty();
+    }
+    return empty;
+}
+
+// Coordinators don't remove themselves from the registry when they're
+// destroyed, as that would put every close on the same path as opening, so
+// this thread periodically sweeps out the expired entries instead. It's
+// started when a coordinator is added and exits once the registry is empty.
+class CoordinatorSweeper {
+public:
+    ~CoordinatorSweeper()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_should_stop = true;
+        }
+        m_cv.notify_one();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    void start()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running || m_should_stop) {
+            return;
+        }
+        if (m_thread.joinable()) {
+            // Has already exited, as it clears m_running just before doing so
+            m_thread.join();
+        }
+        m_thread = std::thread([this] { run(); });
+        m_running = true;
+    }
+
+private:
+    static constexpr std::chrono::seconds sweep_interval{10};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+    bool m_running = false;
+    bool m_should_stop = false;
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_should_stop) {
+            m_cv.wait_for(lock, sweep_interval);
+            if (m_should_stop) {
+                break;
+            }
+            lock.unlock();
+            bool empty = sweep_expired_coordinators();
+            lock.lock();
+            if (empty) {
+                break;
+            }
+        }
+        m_running = false;
+    }
+};
+
+constexpr std::chrono::seconds CoordinatorSweeper::sweep_interval;
+
+// Destroyed before the shards, so the thread never sees them destroyed
+CoordinatorSweeper s_coordinator_sweeper;
+} // anonymous namespace
+
+std::shared_ptr<RealmCoordinator> RealmCoordinator::get_coordinator(StringData path)
+{
+    std::string key = path;
+    auto& shard = shard_for_path(key);
+    if (auto coordinator = find_coordinator(*shard.coordinators.load(), key)) {
         return coordinator;
     }
 
-    auto coordinator = std::make_shared<RealmCoordinator>();
-    weak_coordinator = coordinator;
+    std::shared_ptr<RealmCoordinator> coordinator;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        // Another thread may have created it while we were waiting for the lock
+        auto current = shard.coordinators.load();
+        if ((coordinator = find_coordinator(*current, key))) {
+            return coordinator;
+        }
+
+        // The map has to be copied anyway, so drop any expired entries rather
+        // than waiting for the sweeper to do so
+        auto coordinators = copy_live_coordinators(*current, 1);
+        coordinator = std::make_shared<RealmCoordinator>();
+        (*coordinators)[key] = coordinator;
+        shard.coordinators.store(std::move(coordinators));
+    }
+
+    s_coordinator_sweeper.start();
     return coordinator;
 }
 
 std::shared_ptr<RealmCoordinator> RealmCoordinator::get_existing_coordinator(StringData path)
 {
-    std::lock_guard<std::mutex> lock(s_coordinator_mutex);
-    auto it = s_coordinators_per_path.find(path);
-    return it == s_coordinators_per_path.end() ? nullptr : it->second.lock();
+    std::string key = path;
+    return find_coordinator(*shard_for_path(key).coordinators.load(), key);
 }
 
 std::shared_ptr<Realm> RealmCoordinator::get_realm(Realm::Config config)
@@ -73,6 +218,9 @@ std::shared_ptr<Realm> RealmCoordinator::get_realm(Realm::Config config)
         if (m_config.in_memory != config.in_memory) {
             throw MismatchedConfigException("Realm at path '%1' already opened with different inMemory settings.", config.path);
         }
+        if (!m_config.in_memory && m_config.durability != config.durability) {
+            throw MismatchedConfigException("Realm at path '%1' already opened with a different durability.", config.path);
+        }
         if (m_config.encryption_key != config.encryption_key) {
             throw MismatchedConfigException("Realm at path '%1' already opened with a different encryption key.", config.path);
         }
@@ -98,6 +246,11 @@ std::shared_ptr<Realm> RealmCoordinator::get_realm(Realm::Config config)
     }
 
     auto realm = Realm::make_shared_realm(std::move(config));
+    if (!m_did_open_file) {
+        // Before anything else (such as the notifier) opens the file
+        compact_on_launch_if_needed(*realm);
+        m_did_open_file = true;
+    }
     if (!config.read_only() && !m_notifier && config.automatic_change_notifications) {
         try {
             m_notifier = std::make_unique<ExternalCommitHelper>(*this);
@@ -117,6 +270,26 @@ std::shared_ptr<Realm> RealmCoordinator::get_realm()
     return get_realm(m_config);
 }
 
+void RealmCoordinator::compact_on_launch_if_needed(Realm& realm)
+{
+    if (m_config.read_only() || m_config.in_memory || !m_config.should_compact_on_launch_function) {
+        return;
+    }
+
+    auto& sg = Realm::Internal::get_shared_group(realm);
+    size_t free_space = 0;
+    size_t used_space = 0;
+    // get_stats() requires a read transaction
+    sg.begin_read();
+    sg.get_stats(free_space, used_space);
+    sg.end_read();
+    if (m_config.should_compact_on_launch_function(free_space + used_space, used_space)) {
+        // Returns false without doing anything if another process has the
+        // file open, which isn't an error
+        sg.compact();
+    }
+}
+
 const Schema* RealmCoordinator::get_schema() const noexcept
 {
     return m_schema_version == uint64_t(-1) ? nullptr : &m_schema;
@@ -138,13 +311,35 @@ RealmCoordinator::RealmCoordinator() = default;
 
 RealmCoordinator::~RealmCoordinator()
 {
-    std::lock_guard<std::mutex> coordinator_lock(s_coordinator_mutex);
-    for (auto it = s_coordinators_per_path.begin(); it != s_coordinators_per_path.end(); ) {
-        if (it->second.expired()) {
-            it = s_coordinators_per_path.erase(it);
+    // Only wait for the tasks to notice that they've been cancelled, not for
+    // them to finish, as a rate-limited copy can take minutes
+    m_background_tasks_cancelled = true;
+    for (auto& task : m_background_tasks) {
+        task.wait();
+    }
+
+    if (m_background_writer) {
+        {
+            std::lock_guard<std::mutex> lock(m_background_writer->mutex);
+            m_background_writer->should_stop = true;
+        }
+        m_background_writer->cv.notify_one();
+        // The writer thread itself may have released the last reference
+        if (m_background_writer_thread.get_id() == std::this_thread::get_id()) {
+            m_background_writer_thread.detach();
         }
         else {
-            ++it;
+            m_background_writer_thread.join();
+        }
+    }
+
+    if (m_commits_since_flush > 0) {
+        // Nothing can report a failure here, and the commits themselves have
+        // already succeeded
+        try {
+            do_flush();
+        }
+        catch (...) {
         }
     }
 }
@@ -159,11 +354,15 @@ void RealmCoordinator::unregister_realm(Realm* realm)
 
 void RealmCoordinator::clear_cache()
 {
-    std::vector<WeakRealm> realms_to_close;
-    {
-        std::lock_guard<std::mutex> lock(s_coordinator_mutex);
+    std::vector<std::shared_ptr<const CoordinatorMap>> cleared;
+    for (auto& shard : s_coordinator_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        cleared.push_back(shard.coordinators.exchange(std::make_shared<const CoordinatorMap>()));
+    }
 
-        for (auto& weak_coordinator : s_coordinators_per_path) {
+    std::vector<WeakRealm> realms_to_close;
+    for (auto& coordinators : cleared) {
+        for (auto& weak_coordinator : *coordinators) {
             auto coordinator = weak_coordinator.second.lock();
             if (!coordinator) {
                 continue;
@@ -178,12 +377,11 @@ void RealmCoordinator::clear_cache()
                 }
             }
         }
-
-        s_coordinators_per_path.clear();
     }
 
-    // Close all of the previously cached Realms. This can't be done while
-    // s_coordinator_mutex is held as it may try to re-lock it.
+    // Close all of the previously cached Realms. This is done after
+    // gathering them all as closing may release the last reference to a
+    // coordinator.
     for (auto& weak_realm : realms_to_close) {
         if (auto realm = weak_realm.lock()) {
             realm->close();
@@ -194,10 +392,9 @@ void RealmCoordinator::clear_cache()
 void RealmCoordinator::clear_all_caches()
 {
     std::vector<std::weak_ptr<RealmCoordinator>> to_clear;
-    {
-        std::lock_guard<std::mutex> lock(s_coordinator_mutex);
-        for (auto iter : s_coordinators_per_path) {
-            to_clear.push_back(iter.second);
+    for (auto& shard : s_coordinator_shards) {
+        for (auto& entry : *shard.coordinators.load()) {
+            to_clear.push_back(entry.second);
         }
     }
     for (auto weak_coordinator : to_clear) {
@@ -215,6 +412,293 @@ void RealmCoordinator::send_commit_notifications()
     }
 }
 
+void RealmCoordinator::notify_realm(Realm& realm)
+{
+    std::lock_guard<std::mutex> lock(m_realm_mutex);
+    for (auto& weak_realm_notifier : m_weak_realm_notifiers) {
+        if (weak_realm_notifier.is_for_realm(&realm)) {
+            weak_realm_notifier.notify();
+            return;
+        }
+    }
+}
+
+bool RealmCoordinator::defers_syncing() const noexcept
+{
+#ifdef REALM_ASYNC_DAEMON
+    return !m_config.in_memory && m_config.durability == Realm::Config::Durability::Deferred;
+#else
+    // Core syncs every commit itself, so there's never anything to flush
+    return false;
+#endif
+}
+
+void RealmCoordinator::did_commit()
+{
+    if (!defers_syncing()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_flush_mutex);
+    ++m_commits_since_flush;
+    bool commits_due = m_config.flush_after_commits > 0
+                    && m_commits_since_flush >= m_config.flush_after_commits;
+    bool interval_due = m_config.flush_interval.count() > 0
+                     && std::chrono::steady_clock::now() - m_last_flush >= m_config.flush_interval;
+    if (commits_due || interval_due) {
+        do_flush();
+    }
+}
+
+void RealmCoordinator::flush()
+{
+    if (!defers_syncing()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_flush_mutex);
+    do_flush();
+}
+
+void RealmCoordinator::do_flush()
+{
+    // Syncing any handle to the file flushes the pages written through every
+    // other process's mapping of it, as they share the OS's page cache
+    util::File file(m_config.path, util::File::mode_Update);
+    file.sync();
+    m_commits_since_flush = 0;
+    m_last_flush = std::chrono::steady_clock::now();
+}
+
+void RealmCoordinator::enqueue_write(Realm& realm, std::function<void (SharedRealm)> write,
+                                     std::function<void (std::exception_ptr)> completion)
+{
+    if (!push_queued_write({std::move(write), std::move(completion)})) {
+        return;
+    }
+
+    // Bound how long the calling thread can be kept here by writes which
+    // other threads keep queueing, and hand whatever's left to a background
+    // thread once it has done its share
+    const size_t max_batches_on_calling_thread = 4;
+    auto completion_error = drain_write_queue(realm, max_batches_on_calling_thread, false);
+    if (completion_error) {
+        std::rethrow_exception(completion_error);
+    }
+}
+
+void RealmCoordinator::enqueue_background_write(std::function<void (SharedRealm)> write,
+                                                std::function<void (std::exception_ptr)> completion)
+{
+    if (push_queued_write({std::move(write), std::move(completion)})) {
+        perform_queued_writes_in_background();
+    }
+}
+
+struct RealmCoordinator::BackgroundWriter {
+    std::mutex mutex;
+    std::condition_variable cv;
+    // The coordinator whose queued writes have been handed off to the writer
+    // thread. Holding it here keeps the coordinator alive until the writer
+    // thread picks them up.
+    std::shared_ptr<RealmCoordinator> pending;
+    bool should_stop = false;
+};
+
+void RealmCoordinator::perform_queued_writes_in_background()
+{
+    std::shared_ptr<BackgroundWriter> writer;
+    try {
+        std::lock_guard<std::mutex> lock(m_write_queue_mutex);
+        if (!m_background_writer) {
+            auto new_writer = std::make_shared<BackgroundWriter>();
+            m_background_writer_thread = std::thread(run_background_writer, new_writer);
+            m_background_writer = std::move(new_writer);
+        }
+        writer = m_background_writer;
+    }
+    catch (...) {
+        fail_queued_writes(std::current_exception());
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        writer->pending = shared_from_this();
+    }
+    writer->cv.notify_one();
+}
+
+void RealmCoordinator::run_background_writer(std::shared_ptr<BackgroundWriter> writer)
+{
+    while (true) {
+        std::shared_ptr<RealmCoordinator> coordinator;
+        {
+            std::unique_lock<std::mutex> lock(writer->mutex);
+            writer->cv.wait(lock, [&] { return writer->pending || writer->should_stop; });
+            if (!writer->pending) {
+                return;
+            }
+            coordinator = std::move(writer->pending);
+        }
+        coordinator->perform_background_writes();
+        // If this was the last reference to the coordinator it's destroyed
+        // here, and detaches this thread rather than joining it
+    }
+}
+
+void RealmCoordinator::perform_background_writes()
+{
+    SharedRealm realm;
+    try {
+        auto config = get_config();
+        config.cache = false;
+        // Use the coordinator's schema rather than revalidating it
+        config.schema = util::none;
+        // Not registered with the coordinator, as nothing is ever delivered
+        // to it and some platforms can't create an event loop signal for a
+        // thread with no event loop
+        realm = Realm::make_shared_realm(std::move(config));
+        realm->init(shared_from_this());
+    }
+    catch (...) {
+        fail_queued_writes(std::current_exception());
+        return;
+    }
+
+    // There's nothing on this thread to report a throwing completion
+    // handler to, so any such error is dropped
+    drain_write_queue(*realm, std::numeric_limits<size_t>::max(), true);
+}
+
+void RealmCoordinator::fail_queued_writes(std::exception_ptr error)
+{
+    // Fail everything which was waiting rather than leaving it queued forever
+    std::vector<QueuedWrite> writes;
+    {
+        std::lock_guard<std::mutex> lock(m_write_queue_mutex);
+        writes.swap(m_write_queue);
+        m_performing_queued_writes = false;
+    }
+    std::exception_ptr completion_error;
+    for (auto& write : writes) {
+        call_completion(write, error, completion_error);
+    }
+}
+
+bool RealmCoordinator::push_queued_write(QueuedWrite write)
+{
+    std::lock_guard<std::mutex> lock(m_write_queue_mutex);
+    m_write_queue.push_back(std::move(write));
+    if (m_performing_queued_writes) {
+        return false;
+    }
+    m_performing_queued_writes = true;
+    return true;
+}
+
+std::exception_ptr RealmCoordinator::drain_write_queue(Realm& realm, size_t max_batches,
+                                                       bool notify_after_each_batch)
+{
+    std::exception_ptr completion_error;
+    for (size_t batches = 0; ; ++batches) {
+        std::vector<QueuedWrite> writes;
+        {
+            std::lock_guard<std::mutex> lock(m_write_queue_mutex);
+            if (m_write_queue.empty()) {
+                m_performing_queued_writes = false;
+                return completion_error;
+            }
+            if (batches == max_batches) {
+                // Still marked as performing them, so nothing else can start
+                // draining the queue before the background thread does
+                break;
+            }
+            writes.swap(m_write_queue);
+        }
+        perform_queued_writes(realm, std::move(writes), completion_error);
+        if (notify_after_each_batch) {
+            // The completions may be waiting for the next notify() on
+            // their Realm's thread, which the commit itself may have
+            // already triggered before they were called
+            send_commit_notifications();
+        }
+    }
+
+    perform_queued_writes_in_background();
+    return completion_error;
+}
+
+void RealmCoordinator::call_completion(QueuedWrite& write, std::exception_ptr error,
+                                       std::exception_ptr& completion_error)
+{
+    if (!write.completion) {
+        return;
+    }
+    // A throwing completion handler mustn't stop the rest of the queue from
+    // being performed, so the first such error is held until the drain is done
+    try {
+        write.completion(error);
+    }
+    catch (...) {
+        if (!completion_error) {
+            completion_error = std::current_exception();
+        }
+    }
+}
+
+void RealmCoordinator::perform_queued_writes(Realm& realm, std::vector<QueuedWrite> writes,
+                                             std::exception_ptr& completion_error)
+{
+    auto shared_realm = realm.shared_from_this();
+    auto complete = [&](size_t begin, size_t end, std::exception_ptr error) {
+        for (size_t i = begin; i < end; ++i) {
+            call_completion(writes[i], error, completion_error);
+        }
+    };
+
+    // Core has no way to roll back only part of a write transaction, so a
+    // write which throws fails every write which has already run in the same
+    // transaction with its error. Each write is run at most once, and the
+    // writes after the failed one are performed in a new write transaction.
+    size_t begin = 0;
+    while (begin < writes.size()) {
+        try {
+            realm.begin_transaction();
+        }
+        catch (...) {
+            complete(begin, writes.size(), std::current_exception());
+            return;
+        }
+
+        size_t end = begin;
+        std::exception_ptr error;
+        for (; end < writes.size(); ++end) {
+            try {
+                writes[end].write(shared_realm);
+            }
+            catch (...) {
+                error = std::current_exception();
+                ++end;
+                break;
+            }
+        }
+
+        if (!error) {
+            try {
+                realm.commit_transaction();
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+        }
+        if (error && realm.is_in_transaction()) {
+            realm.cancel_transaction();
+        }
+        complete(begin, end, error);
+        begin = end;
+    }
+}
+
 void RealmCoordinator::pin_version(uint_fast64_t version, uint_fast32_t index)
 {
     if (m_async_error) {
@@ -357,45 +841,59 @@ public:
         return false;
     }
 
-    void advance_to_final(SharedGroup::VersionID version)
+    void advance_to_final(SharedGroup::VersionID version, TransactLogRecording* recording=nullptr)
     {
         if (!m_current) {
             transaction::advance(m_sg, nullptr, m_schema_mode, version);
             return;
         }
 
-        transaction::advance(m_sg, *m_current, version);
+        transaction::advance(m_sg, *m_current, version, recording);
 
         // We now need to combine the transaction change info objects so that all of
         // the notifiers see the complete set of changes from their first version to
-        // the most recent one
+        // the most recent one. Each info only needs the tables which were needed
+        // by the notifiers attached at or before its version, so skip merging
+        // any tables which nobody will read from it.
         for (size_t i = m_info.size() - 1; i > 0; --i) {
             auto& cur = m_info[i];
             if (cur.tables.empty())
                 continue;
             auto& prev = m_info[i - 1];
-            if (prev.tables.empty()) {
-                prev.tables = cur.tables;
-                continue;
-            }
-
-            for (size_t j = 0; j < prev.tables.size() && j < cur.tables.size(); ++j) {
-                prev.tables[j].merge(CollectionChangeBuilder{cur.tables[j]});
-            }
-            prev.tables.reserve(cur.tables.size());
-            while (prev.tables.size() < cur.tables.size()) {
-                prev.tables.push_back(cur.tables[prev.tables.size()]);
+            size_t count = std::min(cur.tables.size(), prev.table_modifications_needed.size());
+            if (prev.tables.size() < count)
+                prev.tables.resize(count);
+
+            for (size_t j = 0; j < count; ++j) {
+                if (!prev.table_modifications_needed[j] || cur.tables[j].empty())
+                    continue;
+                if (prev.tables[j].empty())
+                    prev.tables[j] = cur.tables[j];
+                else
+                    prev.tables[j].merge(CollectionChangeBuilder{cur.tables[j]});
             }
         }
 
-        // Copy the list change info if there are multiple LinkViews for the same LinkList
+        // Copy the list change info if there are multiple LinkViews for the
+        // same LinkList. Group the entries for each LinkList together (keeping
+        // them in the order they were added within each group) and then merge
+        // each entry into the one before it, so that every entry ends up with
+        // all of the changes from the point it was added.
+        auto& lists = m_current->lists;
+        if (lists.size() < 2)
+            return;
         auto id = [](auto const& list) { return std::tie(list.table_ndx, list.col_ndx, list.row_ndx); };
-        for (size_t i = 1; i < m_current->lists.size(); ++i) {
-            for (size_t j = i; j > 0; --j) {
-                if (id(m_current->lists[i]) == id(m_current->lists[j - 1])) {
-                    m_current->lists[j - 1].changes->merge(CollectionChangeBuilder{*m_current->lists[i].changes});
-                }
-            }
+        std::vector<size_t> order(lists.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return std::make_tuple(lists[a].table_ndx, lists[a].col_ndx, lists[a].row_ndx, a)
+                 < std::make_tuple(lists[b].table_ndx, lists[b].col_ndx, lists[b].row_ndx, b);
+        });
+        for (size_t i = order.size() - 1; i > 0; --i) {
+            auto& later = lists[order[i]];
+            auto& earlier = lists[order[i - 1]];
+            if (id(later) == id(earlier) && later.changes != earlier.changes)
+                earlier.changes->merge(CollectionChangeBuilder{*later.changes});
         }
     }
 
@@ -472,34 +970,106 @@ void RealmCoordinator::run_async_notifiers()
 
     // Advance the non-new notifiers to the same version as we advanced the new
     // ones to (or the latest if there were no new ones)
+    // Record the parsed transaction log while doing so, so that the Realms
+    // which are advanced over the same versions to deliver the results don't
+    // need to parse it again themselves
     IncrementalChangeInfo change_info(*m_notifier_sg, m_config.schema_mode, notifiers);
     for (auto& notifier : notifiers) {
         notifier->add_required_change_info(change_info.current());
     }
-    change_info.advance_to_final(version);
+    auto recording = std::make_shared<TransactLogRecording>();
+    auto from_version = m_notifier_sg->get_version_of_current_transaction().version;
+    change_info.advance_to_final(version, recording.get());
+    auto to_version = m_notifier_sg->get_version_of_current_transaction();
+    if (!notifiers.empty() && from_version != to_version.version)
+        store_transact_log({from_version, to_version.version, to_version.index, std::move(recording)});
 
     // Attach the new notifiers to the main SG and move them to the main list
     for (auto& notifier : new_notifiers) {
         notifier->attach_to(*m_notifier_sg);
     }
+    size_t existing_count = notifiers.size();
     std::move(new_notifiers.begin(), new_notifiers.end(), std::back_inserter(notifiers));
 
     // Change info is now all ready, so the notifiers can now perform their
-    // background work
-    for (auto& notifier : notifiers) {
+    // background work. Run the most urgent notifiers first, and within each
+    // priority the ones which were quickest last time, and hand each existing
+    // notifier over as soon as it's done. Its Realm can then deliver it
+    // without waiting for the slower notifiers, and will pick up the slower
+    // ones once they catch up to the version it advanced to.
+    std::vector<std::pair<NotificationPriority, std::chrono::steady_clock::duration>> keys;
+    keys.reserve(notifiers.size());
+    for (auto& notifier : notifiers)
+        keys.emplace_back(notifier->priority(), notifier->last_run_duration());
+    std::vector<size_t> order(notifiers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return keys[a] < keys[b];
+    });
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        auto& notifier = notifiers[order[i]];
+        auto start = std::chrono::steady_clock::now();
         notifier->run();
+        notifier->set_last_run_duration(std::chrono::steady_clock::now() - start);
+
+        // New notifiers aren't visible to their Realm until they're added to
+        // m_notifiers below, and after the last one every Realm is notified
+        // by on_change() anyway
+        if (order[i] >= existing_count || i + 1 == order.size())
+            continue;
+
+        lock.lock();
+        notifier->prepare_handover();
+        lock.unlock();
+        if (auto realm = notifier->get_realm())
+            notify_realm(*realm);
     }
 
     // Reacquire the lock while updating the fields that are actually read on
     // other threads
     lock.lock();
-    for (auto& notifier : notifiers) {
-        notifier->prepare_handover();
-    }
+    if (!order.empty() && order.back() < existing_count)
+        notifiers[order.back()]->prepare_handover();
+    for (size_t i = existing_count; i < notifiers.size(); ++i)
+        notifiers[i]->prepare_handover();
     m_notifiers = std::move(notifiers);
     clean_up_dead_notifiers();
 }
 
+void RealmCoordinator::store_transact_log(RecordedTransactLog recorded)
+{
+    // Realms normally advance to the notifier version soon after the worker
+    // does, so only the last few logs are worth keeping around
+    const size_t max_recorded_logs = 8;
+
+    std::lock_guard<std::mutex> lock(m_transact_log_mutex);
+    if (m_recorded_transact_logs.size() == max_recorded_logs)
+        m_recorded_transact_logs.erase(m_recorded_transact_logs.begin());
+    m_recorded_transact_logs.push_back(std::move(recorded));
+}
+
+std::shared_ptr<const TransactLogRecording> RealmCoordinator::recorded_transact_log(uint_fast64_t from_version,
+                                                                                    uint_fast64_t to_version)
+{
+    std::lock_guard<std::mutex> lock(m_transact_log_mutex);
+    for (auto& recorded : m_recorded_transact_logs) {
+        if (recorded.from_version == from_version && recorded.to_version == to_version)
+            return recorded.log;
+    }
+    return nullptr;
+}
+
+RealmCoordinator::RecordedTransactLog RealmCoordinator::latest_recorded_transact_log(uint_fast64_t from_version)
+{
+    std::lock_guard<std::mutex> lock(m_transact_log_mutex);
+    for (auto it = m_recorded_transact_logs.rbegin(); it != m_recorded_transact_logs.rend(); ++it) {
+        if (it->from_version == from_version)
+            return *it;
+    }
+    return {};
+}
+
 void RealmCoordinator::open_helper_shared_group()
 {
     if (!m_notifier_sg) {
@@ -522,8 +1092,12 @@ void RealmCoordinator::open_helper_shared_group()
 }
 
 
-std::vector<std::shared_ptr<_impl::CollectionNotifier>> RealmCoordinator::notifiers_to_deliver(Realm& realm)
+std::vector<std::shared_ptr<_impl::CollectionNotifier>>
+RealmCoordinator::notifiers_to_deliver(Realm& realm, bool newest, bool* has_notifiers)
 {
+    if (has_notifiers)
+        *has_notifiers = false;
+
     std::unique_lock<std::mutex> lock(m_notifier_mutex);
     decltype(m_notifiers) notifiers;
     if (m_async_error) {
@@ -535,9 +1109,27 @@ std::vector<std::shared_ptr<_impl::CollectionNotifier>> RealmCoordinator::notifi
         return {};
     }
 
+    // Each notifier is handed over as soon as it's run, so the Realm's
+    // notifiers may be ready for different versions. Only the ones for the
+    // target version are packaged, and the rest keep accumulating changes
+    // until they catch up.
+    auto version = Realm::Internal::get_shared_group(realm).get_version_of_current_transaction();
+    auto target = version;
     for (auto& notifier : m_notifiers) {
-        auto notifier_version = notifier->package_for_delivery(realm);
-        if (notifier_version == SharedGroup::VersionID{})
+        if (!notifier->is_for_realm(realm))
+            continue;
+        if (has_notifiers)
+            *has_notifiers = true;
+        if (newest && target < notifier->version())
+            target = notifier->version();
+    }
+    if (newest && target == version)
+        return {};
+
+    for (auto& notifier : m_notifiers) {
+        if (notifier->version() != target)
+            continue;
+        if (notifier->package_for_delivery(realm) == SharedGroup::VersionID{})
             continue;
         notifiers.push_back(notifier);
     }
@@ -548,19 +1140,37 @@ std::vector<std::shared_ptr<_impl::CollectionNotifier>> RealmCoordinator::notifi
 void RealmCoordinator::advance_to_ready(Realm& realm)
 {
     auto& sg = Realm::Internal::get_shared_group(realm);
-    auto notifiers = notifiers_to_deliver(realm);
-    if (notifiers.empty()) {
-        transaction::advance(sg, realm.m_binding_context.get(), m_config.schema_mode);
+    bool has_notifiers;
+    auto notifiers = notifiers_to_deliver(realm, true, &has_notifiers);
+    if (!has_notifiers) {
+        // If the notifier worker has already parsed the logs from our current
+        // version, advance to the version it advanced to so that we can reuse
+        // its work. With no notifiers there's nothing to wait for, so if
+        // there's been a commit since the worker ran, continue on to the
+        // latest version by parsing just the logs it hasn't.
+        auto recorded = latest_recorded_transact_log(sg.get_version_of_current_transaction().version);
+        if (recorded.log) {
+            transaction::advance(sg, realm.m_binding_context.get(), m_config.schema_mode,
+                                 SharedGroup::VersionID(recorded.to_version, recorded.to_index),
+                                 recorded.log.get());
+        }
+        if (!recorded.log || sg.has_changed()) {
+            transaction::advance(sg, realm.m_binding_context.get(), m_config.schema_mode);
+        }
         return;
     }
 
-    auto version = notifiers[0]->version();
-    if (version <= sg.get_version_of_current_transaction())
+    // Advance to the newest version which any of our notifiers are ready for
+    // and deliver the ones for that version
+    if (notifiers.empty())
         return;
+    auto version = notifiers[0]->version();
+
+    auto recording = recorded_transact_log(sg.get_version_of_current_transaction().version, version.version);
 
     for (auto& notifier : notifiers)
         notifier->before_advance();
-    transaction::advance(sg, realm.m_binding_context.get(), m_config.schema_mode, version);
+    transaction::advance(sg, realm.m_binding_context.get(), m_config.schema_mode, version, recording.get());
     for (auto& notifier : notifiers)
         notifier->deliver(sg);
     for (auto& notifier : notifiers)
@@ -569,14 +1179,11 @@ void RealmCoordinator::advance_to_ready(Realm& realm)
 
 void RealmCoordinator::process_available_async(Realm& realm)
 {
-    auto notifiers = notifiers_to_deliver(realm);
+    auto notifiers = notifiers_to_deliver(realm, false);
     if (notifiers.empty())
         return;
 
     auto& sg = Realm::Internal::get_shared_group(realm);
-    auto version = notifiers[0]->version();
-    if (version != sg.get_version_of_current_transaction())
-        return;
 
     for (auto& notifier : notifiers)
         notifier->deliver(sg);
@@ -21,7 +21,14 @@
 
 #include "shared_realm.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
 #include <mutex>
+#include <thread>
 
 namespace realm {
 class Replication;
@@ -33,6 +40,7 @@ namespace _impl {
 class CollectionNotifier;
 class ExternalCommitHelper;
 class WeakRealmNotifier;
+struct TransactLogRecording;
 
 // RealmCoordinator manages the weak cache of Realm instances and communication
 // between per-thread Realm instances for a given file
@@ -60,6 +68,15 @@ public:
     // Asynchronously call notify() on every Realm instance for this coordinator's
     // path, including those in other processes
     void send_commit_notifications();
+    // Asynchronously call notify() on only the given Realm instance
+    void notify_realm(Realm& realm);
+
+    // Sync the file to disk if the flush policy for Deferred durability says
+    // it's due. Called after each commit made by a Realm for this file.
+    void did_commit();
+    // Sync everything committed so far to disk, unless core already syncs
+    // each commit
+    void flush();
 
     // Clear the weak Realm cache for all paths
     // Should only be called in test code, as continuing to use the previously
@@ -85,6 +102,32 @@ public:
 
     static void register_notifier(std::shared_ptr<CollectionNotifier> notifier);
 
+    // Queue a write to be performed in a single write transaction along with
+    // every other write queued on this coordinator before it is performed.
+    // If no queued writes are currently being performed, the calling thread
+    // performs a few batches of them using the given Realm and then leaves
+    // any remaining to the background writer thread; otherwise the write is
+    // left for the thread already doing so and this returns immediately. If
+    // a completion handler called on this thread throws, the first such
+    // error is rethrown once the calling thread is done with the queue.
+    void enqueue_write(Realm& realm, std::function<void (SharedRealm)> write,
+                       std::function<void (std::exception_ptr)> completion);
+    // Queue a write in the same way, but hand the queued writes off to the
+    // coordinator's background writer thread if they aren't already being
+    // performed, so that the calling thread never waits for the write lock or
+    // the commit. The completion handler is called on that thread and must
+    // not throw.
+    void enqueue_background_write(std::function<void (SharedRealm)> write,
+                                  std::function<void (std::exception_ptr)> completion);
+
+    // Run a task on a new thread owned by this coordinator, which waits for
+    // it to complete on destruction. The task is called with a flag which is
+    // set when the coordinator starts being destroyed, and should poll it to
+    // stop early rather than making closing the last Realm wait for it. The
+    // task must not hold a reference to the coordinator.
+    template<typename Task>
+    void run_background_task(Task&& task);
+
     // Advance the Realm to the most recent transaction version which all async
     // work is complete for
     void advance_to_ready(Realm& realm);
@@ -97,6 +140,8 @@ private:
 
     std::mutex m_realm_mutex;
     std::vector<WeakRealmNotifier> m_weak_realm_notifiers;
+    // Set once the first Realm for this coordinator has opened the file
+    bool m_did_open_file = false;
 
     std::mutex m_notifier_mutex;
     std::vector<std::shared_ptr<_impl::CollectionNotifier>> m_new_notifiers;
@@ -116,6 +161,45 @@ private:
 
     std::unique_ptr<_impl::ExternalCommitHelper> m_notifier;
 
+    // The transaction logs decoded by the notifier worker for the most recent
+    // advances of m_notifier_sg, which Realms advancing over the same range of
+    // versions can replay rather than decoding the logs again
+    struct RecordedTransactLog {
+        uint_fast64_t from_version;
+        uint_fast64_t to_version;
+        uint_fast32_t to_index;
+        std::shared_ptr<const TransactLogRecording> log;
+    };
+    std::mutex m_transact_log_mutex;
+    std::vector<RecordedTransactLog> m_recorded_transact_logs;
+
+    struct QueuedWrite {
+        std::function<void (SharedRealm)> write;
+        std::function<void (std::exception_ptr)> completion;
+    };
+    std::mutex m_write_queue_mutex;
+    std::vector<QueuedWrite> m_write_queue;
+    // Set while a thread is performing the queued writes
+    bool m_performing_queued_writes = false;
+    // The thread which performs queued writes that have been handed off to
+    // the background. It's started the first time that happens, waits for
+    // further hand-offs after draining the queue, and is joined on
+    // destruction.
+    struct BackgroundWriter;
+    std::shared_ptr<BackgroundWriter> m_background_writer;
+    std::thread m_background_writer_thread;
+
+    std::mutex m_background_task_mutex;
+    std::vector<std::future<void>> m_background_tasks;
+    std::atomic<bool> m_background_tasks_cancelled{false};
+
+    std::mutex m_flush_mutex;
+    size_t m_commits_since_flush = 0;
+    std::chrono::steady_clock::time_point m_last_flush = std::chrono::steady_clock::now();
+
+    // Apply the config's compact-on-launch policy using the first Realm
+    // opened for the file. Must be called with m_realm_mutex locked.
+    void compact_on_launch_if_needed(Realm& realm);
     // must be called with m_notifier_mutex locked
     void pin_version(uint_fast64_t version, uint_fast32_t index);
 
@@ -123,9 +207,56 @@ private:
     void open_helper_shared_group();
     void advance_helper_shared_group_to_latest();
     void clean_up_dead_notifiers();
-    std::vector<std::shared_ptr<_impl::CollectionNotifier>> notifiers_to_deliver(Realm&);
+    // Whether commits are left for core's async commit daemon to sync, so
+    // that the flush policy applies
+    bool defers_syncing() const noexcept;
+    // must be called with m_flush_mutex locked
+    void do_flush();
+    void store_transact_log(RecordedTransactLog recorded);
+    std::shared_ptr<const TransactLogRecording> recorded_transact_log(uint_fast64_t from_version,
+                                                                      uint_fast64_t to_version);
+    // Get the most recent recording which starts at the given version, if any
+    RecordedTransactLog latest_recorded_transact_log(uint_fast64_t from_version);
+    // Returns true if the caller is now responsible for performing the queued writes
+    bool push_queued_write(QueuedWrite write);
+    // Hand the queued writes off to the background writer thread, starting
+    // it if needed. Must only be called by whoever is responsible for
+    // performing them.
+    void perform_queued_writes_in_background();
+    static void run_background_writer(std::shared_ptr<BackgroundWriter> writer);
+    void perform_background_writes();
+    // Call every queued write's completion with the given error and clear the queue
+    void fail_queued_writes(std::exception_ptr error);
+    // Perform batches of queued writes until the queue is empty or
+    // `max_batches` have been performed, in which case the rest are handed
+    // off to the background writer thread. Returns the first error thrown by
+    // a completion handler, if any.
+    std::exception_ptr drain_write_queue(Realm& realm, size_t max_batches, bool notify_after_each_batch);
+    void perform_queued_writes(Realm& realm, std::vector<QueuedWrite> writes,
+                               std::exception_ptr& completion_error);
+    static void call_completion(QueuedWrite& write, std::exception_ptr error,
+                                std::exception_ptr& completion_error);
+    // Package the Realm's notifiers which are ready for delivery at a single
+    // version. If `newest` is true, that is the newest version any of them
+    // have been handed over at if it's newer than the Realm's current version,
+    // and otherwise it's the Realm's current version. `has_notifiers` is set
+    // to whether the Realm has any notifiers at all.
+    std::vector<std::shared_ptr<_impl::CollectionNotifier>> notifiers_to_deliver(Realm&, bool newest,
+                                                                                 bool* has_notifiers=nullptr);
 };
 
+template<typename Task>
+void RealmCoordinator::run_background_task(Task&& task)
+{
+    std::lock_guard<std::mutex> lock(m_background_task_mutex);
+    // Drop the tasks which have already finished
+    m_background_tasks.erase(std::remove_if(m_background_tasks.begin(), m_background_tasks.end(), [](auto& task) {
+        return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), m_background_tasks.end());
+    m_background_tasks.push_back(std::async(std::launch::async, std::forward<Task>(task),
+                                            std::cref(m_background_tasks_cancelled)));
+}
+
 } // namespace _impl
 } // namespace realm
 
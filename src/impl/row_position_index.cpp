@@ -0,0 +1,34 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "impl/row_position_index.hpp"
+
+#include "shared_realm.hpp"
+
+#include <realm/group_shared.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+uint_fast64_t RowPositionIndex::transaction_version(Realm& realm)
+{
+    // Read-only Realms are a single unchanging version
+    if (realm.config().read_only())
+        return 0;
+    return Realm::Internal::get_shared_group(realm).get_version_of_current_transaction().version;
+}
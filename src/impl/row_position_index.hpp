@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_ROW_POSITION_INDEX_HPP
+#define REALM_ROW_POSITION_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace realm {
+class Realm;
+
+namespace _impl {
+// A lazily-built map from row index to the position of its first occurrence
+// in a List or Results, so that repeatedly looking up rows (e.g. to check the
+// selection state of every visible cell) is O(1) rather than a scan each time.
+//
+// The index is tagged with a version supplied by the owner, and is discarded
+// whenever the owner reports a different version.
+class RowPositionIndex {
+public:
+    // Collections smaller than this are always scanned
+    static constexpr size_t min_size = 16;
+
+    RowPositionIndex() = default;
+
+    // Copying a collection shouldn't copy its index, which may be large and
+    // is rebuilt on demand, so copies start out empty and unbuilt
+    RowPositionIndex(RowPositionIndex const&) noexcept { }
+    RowPositionIndex& operator=(RowPositionIndex const& other) noexcept
+    {
+        if (this != &other) {
+            invalidate();
+            m_version = -1;
+        }
+        return *this;
+    }
+
+    RowPositionIndex(RowPositionIndex&&) = default;
+    RowPositionIndex& operator=(RowPositionIndex&&) = default;
+
+    // Discard the index if it was built for a different version
+    void set_version(uint_fast64_t version) noexcept
+    {
+        if (version != m_version) {
+            invalidate();
+            m_version = version;
+        }
+    }
+
+    void invalidate() noexcept
+    {
+        m_positions.clear();
+        m_built = false;
+        m_lookups = 0;
+    }
+
+    // Find the position of `row_ndx`, or `npos` if it's not present. `scan`
+    // performs a linear search and is used until a second lookup at the same
+    // version shows the index to be worth building, which is done by calling
+    // `get` for each position up to `size`. `get` may return `npos` for
+    // entries which should be skipped (such as detached rows).
+    template<typename Scan, typename Get>
+    size_t find(size_t row_ndx, size_t size, Scan&& scan, Get&& get)
+    {
+        if (!m_built) {
+            if (size < min_size || ++m_lookups < 2)
+                return scan();
+
+            m_positions.reserve(size);
+            for (size_t i = 0; i < size; ++i) {
+                size_t row = get(i);
+                if (row != size_t(-1))
+                    m_positions.emplace(row, i);
+            }
+            m_built = true;
+        }
+
+        auto it = m_positions.find(row_ndx);
+        return it == m_positions.end() ? size_t(-1) : it->second;
+    }
+
+    // The version of the given Realm's current read transaction, which
+    // identifies the contents of any collection outside of write transactions
+    static uint_fast64_t transaction_version(Realm& realm);
+
+private:
+    std::unordered_map<size_t, size_t> m_positions;
+    uint_fast64_t m_version = -1;
+    size_t m_lookups = 0;
+    bool m_built = false;
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_ROW_POSITION_INDEX_HPP
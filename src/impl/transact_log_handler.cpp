@@ -567,8 +567,23 @@ public:
 
 // Extends TransactLogValidator to track changes made to LinkViews
 class LinkViewObserver : public TransactLogValidationMixin, public MarkDirtyMixin<LinkViewObserver> {
+    using Type = _impl::TransactLogRecording::Type;
+
     _impl::TransactionChangeInfo& m_info;
     _impl::CollectionChangeBuilder* m_active = nullptr;
+    _impl::TransactLogRecording* m_recording;
+
+    void record(Type type, size_t a=0, size_t b=0, size_t c=0, size_t d=0)
+    {
+        if (m_recording)
+            m_recording->add(type, a, b, c, d);
+    }
+
+    void mark_row_dirty(size_t row, size_t col)
+    {
+        if (auto change = get_change())
+            change->modify(row, col);
+    }
 
     _impl::CollectionChangeBuilder* get_change()
     {
@@ -588,13 +603,25 @@ class LinkViewObserver : public TransactLogValidationMixin, public MarkDirtyMixi
     }
 
 public:
-    LinkViewObserver(_impl::TransactionChangeInfo& info)
-    : m_info(info) { }
+    LinkViewObserver(_impl::TransactionChangeInfo& info, _impl::TransactLogRecording* recording)
+    : m_info(info), m_recording(recording) { }
 
-    void mark_dirty(size_t row, size_t)
+    void mark_dirty(size_t row, size_t col)
     {
-        if (auto change = get_change())
-            change->modify(row);
+        record(Type::Set, row, col);
+        mark_row_dirty(row, col);
+    }
+
+    bool select_table(size_t group_level_ndx, int levels, const size_t* path)
+    {
+        record(Type::SelectTable, group_level_ndx);
+        return TransactLogValidationMixin::select_table(group_level_ndx, levels, path);
+    }
+
+    bool set_link_type(size_t col, LinkType type)
+    {
+        record(Type::SetLinkType, col, type);
+        return TransactLogValidationMixin::set_link_type(col, type);
     }
 
     void parse_complete()
@@ -607,9 +634,10 @@ public:
         }
     }
 
-    bool select_link_list(size_t col, size_t row, size_t)
+    bool select_link_list(size_t col, size_t row, size_t target_group_level_ndx)
     {
-        mark_dirty(row, col);
+        record(Type::SelectLinkList, col, row, target_group_level_ndx);
+        mark_row_dirty(row, col);
 
         m_active = nullptr;
         // When there are multiple source versions there could be multiple
@@ -626,6 +654,7 @@ public:
 
     bool link_list_set(size_t index, size_t, size_t)
     {
+        record(Type::LinkListSet, index);
         if (m_active)
             m_active->modify(index);
         return true;
@@ -633,13 +662,15 @@ public:
 
     bool link_list_insert(size_t index, size_t, size_t)
     {
+        record(Type::LinkListInsert, index);
         if (m_active)
             m_active->insert(index);
         return true;
     }
 
-    bool link_list_erase(size_t index, size_t)
+    bool link_list_erase(size_t index, size_t prior_size)
     {
+        record(Type::LinkListErase, index, prior_size);
         if (m_active)
             m_active->erase(index);
         return true;
@@ -659,6 +690,7 @@ public:
 
     bool link_list_clear(size_t old_size)
     {
+        record(Type::LinkListClear, old_size);
         if (m_active)
             m_active->clear(old_size);
         return true;
@@ -666,13 +698,15 @@ public:
 
     bool link_list_move(size_t from, size_t to)
     {
+        record(Type::LinkListMove, from, to);
         if (m_active)
             m_active->move(from, to);
         return true;
     }
 
-    bool insert_empty_rows(size_t row_ndx, size_t num_rows_to_insert, size_t, bool unordered)
+    bool insert_empty_rows(size_t row_ndx, size_t num_rows_to_insert, size_t prior_num_rows, bool unordered)
     {
+        record(Type::InsertEmptyRows, row_ndx, num_rows_to_insert, prior_num_rows, unordered);
         REALM_ASSERT(!unordered);
         if (auto change = get_change())
             change->insert(row_ndx, num_rows_to_insert, need_move_info());
@@ -684,8 +718,9 @@ public:
         return true;
     }
 
-    bool erase_rows(size_t row_ndx, size_t, size_t prior_num_rows, bool unordered)
+    bool erase_rows(size_t row_ndx, size_t num_rows_to_erase, size_t prior_num_rows, bool unordered)
     {
+        record(Type::EraseRows, row_ndx, num_rows_to_erase, prior_num_rows, unordered);
         REALM_ASSERT(unordered);
         size_t last_row = prior_num_rows - 1;
 
@@ -708,6 +743,7 @@ public:
     }
 
     bool swap_rows(size_t row_ndx_1, size_t row_ndx_2) {
+        record(Type::SwapRows, row_ndx_1, row_ndx_2);
         REALM_ASSERT(row_ndx_1 < row_ndx_2);
         for (auto& list : m_info.lists) {
             if (list.table_ndx == current_table()) {
@@ -724,6 +760,7 @@ public:
 
     bool merge_rows(size_t from, size_t to)
     {
+        record(Type::MergeRows, from, to);
         for (auto& list : m_info.lists) {
             if (list.table_ndx == current_table() && list.row_ndx == from)
                 list.row_ndx = to;
@@ -735,6 +772,7 @@ public:
 
     bool clear_table()
     {
+        record(Type::ClearTable);
         auto tbl_ndx = current_table();
         auto it = remove_if(begin(m_info.lists), end(m_info.lists),
                             [&](auto const& lv) { return lv.table_ndx == tbl_ndx; });
@@ -746,6 +784,7 @@ public:
 
     bool insert_column(size_t ndx, DataType, StringData, bool)
     {
+        record(Type::InsertColumn, ndx);
         for (auto& list : m_info.lists) {
             if (list.table_ndx == current_table() && list.col_ndx >= ndx)
                 ++list.col_ndx;
@@ -753,8 +792,9 @@ public:
         return true;
     }
 
-    bool insert_group_level_table(size_t ndx, size_t, StringData)
+    bool insert_group_level_table(size_t ndx, size_t prior_size, StringData)
     {
+        record(Type::InsertGroupLevelTable, ndx, prior_size);
         for (auto& list : m_info.lists) {
             if (list.table_ndx >= ndx)
                 ++list.table_ndx;
@@ -767,6 +807,7 @@ public:
 
     bool move_column(size_t from, size_t to)
     {
+        record(Type::MoveColumn, from, to);
         for (auto& list : m_info.lists) {
             if (list.table_ndx == current_table())
                 adjust_for_move(list.col_ndx, from, to);
@@ -776,6 +817,7 @@ public:
 
     bool move_group_level_table(size_t from, size_t to)
     {
+        record(Type::MoveGroupLevelTable, from, to);
         for (auto& list : m_info.lists)
             adjust_for_move(list.table_ndx, from, to);
         rotate(m_info.tables, from, to);
@@ -787,13 +829,139 @@ public:
     bool insert_link_column(size_t ndx, DataType type, StringData name, size_t, size_t) { return insert_column(ndx, type, name, false); }
 
 };
+
+// Replay the instructions recorded by a LinkViewObserver to a different handler
+template<typename Handler>
+void replay(std::vector<_impl::TransactLogRecording::Instruction> const& instructions, Handler& handler)
+{
+    using Type = _impl::TransactLogRecording::Type;
+    for (auto const& i : instructions) {
+        switch (i.type) {
+            case Type::SelectTable:           handler.select_table(i.a, 0, nullptr); break;
+            case Type::InsertGroupLevelTable: handler.insert_group_level_table(i.a, i.b, StringData()); break;
+            case Type::MoveGroupLevelTable:   handler.move_group_level_table(i.a, i.b); break;
+            case Type::InsertColumn:          handler.insert_column(i.a, type_Int, StringData(), false); break;
+            case Type::MoveColumn:            handler.move_column(i.a, i.b); break;
+            case Type::SetLinkType:           handler.set_link_type(i.a, LinkType(i.b)); break;
+            case Type::InsertEmptyRows:       handler.insert_empty_rows(i.a, i.b, i.c, i.d != 0); break;
+            case Type::EraseRows:             handler.erase_rows(i.a, i.b, i.c, i.d != 0); break;
+            case Type::SwapRows:              handler.swap_rows(i.a, i.b); break;
+            case Type::MergeRows:             handler.merge_rows(i.a, i.b); break;
+            case Type::ClearTable:            handler.clear_table(); break;
+            case Type::Set:                   handler.mark_dirty(i.a, i.b); break;
+            case Type::SelectLinkList:        handler.select_link_list(i.a, i.b, i.c); break;
+            case Type::LinkListSet:           handler.link_list_set(i.a, 0, 0); break;
+            case Type::LinkListInsert:        handler.link_list_insert(i.a, 0, 0); break;
+            case Type::LinkListErase:         handler.link_list_erase(i.a, i.b); break;
+            case Type::LinkListClear:         handler.link_list_clear(i.a); break;
+            case Type::LinkListMove:          handler.link_list_move(i.a, i.b); break;
+        }
+    }
+    handler.parse_complete();
+}
+
+// Advance using the recording for the observer rather than having core
+// decode the logs for it. The observer sees the changes before the accessors
+// are updated, just as when it's passed to advance_read().
+void advance_with_recording(SharedGroup& sg, SharedGroup::VersionID version,
+                            _impl::TransactLogRecording const&)
+{
+    LangBindHelper::advance_read(sg, version);
+}
+
+// Validating the schema only needs the schema changes, so skip walking the
+// row-level instructions entirely (and skip everything if there weren't any)
+void advance_with_recording(SharedGroup& sg, SharedGroup::VersionID version,
+                            _impl::TransactLogRecording const& recording, TransactLogValidator&& validator)
+{
+    if (recording.schema_overflowed) {
+        LangBindHelper::advance_read(sg, validator, version);
+        return;
+    }
+    if (!recording.schema_instructions.empty())
+        replay(recording.schema_instructions, validator);
+    LangBindHelper::advance_read(sg, version);
+}
+
+template<typename Handler>
+void advance_with_recording(SharedGroup& sg, SharedGroup::VersionID version,
+                            _impl::TransactLogRecording const& recording, Handler&& handler)
+{
+    if (recording.overflowed) {
+        LangBindHelper::advance_read(sg, handler, version);
+        return;
+    }
+    replay(recording.instructions, handler);
+    LangBindHelper::advance_read(sg, version);
+}
+
+// Arbitrary limit on the size of the recording, above which it's cheaper
+// to just decode the logs again than to keep a copy
+const size_t c_max_recorded_instructions = 100000;
 } // anonymous namespace
 
 namespace realm {
 namespace _impl {
+void TransactLogRecording::add(Type type, size_t a, size_t b, size_t c, size_t d)
+{
+    switch (type) {
+        case Type::SelectTable:
+            m_selected_table = a;
+            break;
+        case Type::InsertGroupLevelTable:
+            // Inserting a table implicitly selects it, as in TransactLogValidationMixin
+            m_selected_table = m_schema_selected_table = a;
+            add_schema_instruction({type, a, b, c, d});
+            break;
+        case Type::MoveGroupLevelTable:
+            add_schema_instruction({type, a, b, c, d});
+            break;
+        case Type::InsertColumn:
+        case Type::MoveColumn:
+        case Type::SetLinkType:
+            if (m_schema_selected_table != m_selected_table) {
+                add_schema_instruction({Type::SelectTable, m_selected_table, 0, 0, 0});
+                m_schema_selected_table = m_selected_table;
+            }
+            add_schema_instruction({type, a, b, c, d});
+            break;
+        default:
+            break;
+    }
+
+    if (overflowed)
+        return;
+    if (instructions.size() >= c_max_recorded_instructions) {
+        overflowed = true;
+        instructions = {};
+        return;
+    }
+    instructions.push_back({type, a, b, c, d});
+}
+
+void TransactLogRecording::add_schema_instruction(Instruction instruction)
+{
+    if (schema_overflowed)
+        return;
+    if (schema_instructions.size() >= c_max_recorded_instructions) {
+        schema_overflowed = true;
+        schema_instructions = {};
+        return;
+    }
+    schema_instructions.push_back(instruction);
+}
+
 namespace transaction {
-void advance(SharedGroup& sg, BindingContext* context, SchemaMode schema_mode, SharedGroup::VersionID version)
+void advance(SharedGroup& sg, BindingContext* context, SchemaMode schema_mode, SharedGroup::VersionID version,
+             TransactLogRecording const* recording)
 {
+    if (recording) {
+        TransactLogObserver(context, sg, [&](auto&&... args) {
+            advance_with_recording(sg, version, *recording, std::move(args)...);
+        }, schema_mode);
+        return;
+    }
+
     TransactLogObserver(context, sg, [&](auto&&... args) {
         LangBindHelper::advance_read(sg, std::move(args)..., version);
     }, schema_mode);
@@ -829,15 +997,15 @@ void cancel(SharedGroup& sg, BindingContext* context)
 
 void advance(SharedGroup& sg,
              TransactionChangeInfo& info,
-             SharedGroup::VersionID version)
+             SharedGroup::VersionID version,
+             TransactLogRecording* recording)
 {
-    if (info.table_modifications_needed.empty() && info.lists.empty()) {
+    if (!recording && info.table_modifications_needed.empty() && info.lists.empty()) {
         LangBindHelper::advance_read(sg, version);
     }
     else {
-        LangBindHelper::advance_read(sg, LinkViewObserver(info), version);
+        LangBindHelper::advance_read(sg, LinkViewObserver(info, recording), version);
     }
-
 }
 
 } // namespace transaction
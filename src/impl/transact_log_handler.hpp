@@ -21,6 +21,8 @@
 
 #include <realm/group_shared.hpp>
 
+#include <vector>
+
 namespace realm {
 class BindingContext;
 enum class SchemaMode : uint8_t;
@@ -28,12 +30,53 @@ enum class SchemaMode : uint8_t;
 namespace _impl {
 struct TransactionChangeInfo;
 
+// A compact copy of the instructions in a range of transaction logs which are
+// of interest to the object store's transaction log handlers. Recording this
+// while the notifier worker advances lets each Realm advancing over the same
+// range replay it to its BindingContext observer or schema validator rather
+// than having core decode the transaction logs a second time for it.
+struct TransactLogRecording {
+    enum class Type : uint8_t {
+        SelectTable, InsertGroupLevelTable, MoveGroupLevelTable,
+        InsertColumn, MoveColumn, SetLinkType,
+        InsertEmptyRows, EraseRows, SwapRows, MergeRows, ClearTable, Set,
+        SelectLinkList, LinkListSet, LinkListInsert, LinkListErase,
+        LinkListClear, LinkListMove
+    };
+    struct Instruction {
+        Type type;
+        size_t a, b, c, d;
+    };
+    std::vector<Instruction> instructions;
+    // The instructions which change the schema, along with the table
+    // selections needed to interpret them. This is all that's needed to
+    // validate the schema, and is kept even if `instructions` overflows.
+    std::vector<Instruction> schema_instructions;
+    // Set if recording `instructions` was abandoned because the logs were too
+    // large to be worth keeping a copy of
+    bool overflowed = false;
+    // Set if recording `schema_instructions` was abandoned for the same reason
+    bool schema_overflowed = false;
+
+    void add(Type type, size_t a=0, size_t b=0, size_t c=0, size_t d=0);
+
+private:
+    size_t m_selected_table = npos;
+    size_t m_schema_selected_table = npos;
+
+    void add_schema_instruction(Instruction instruction);
+};
+
 namespace transaction {
 // Advance the read transaction version, with change notifications sent to delegate
 // Must not be called from within a write transaction.
+// If `recording` is given, it must be a recording of the transaction logs
+// from the current version to `version`, and is replayed to the delegate and
+// validator instead of decoding the transaction logs again.
 void advance(SharedGroup& sg, BindingContext* binding_context,
              SchemaMode schema_mode,
-             SharedGroup::VersionID version=SharedGroup::VersionID{});
+             SharedGroup::VersionID version=SharedGroup::VersionID{},
+             TransactLogRecording const* recording=nullptr);
 
 // Begin a write transaction
 // If the read transaction version is not up to date, will first advance to the
@@ -49,9 +92,12 @@ void commit(SharedGroup& sg, BindingContext* binding_context);
 void cancel(SharedGroup& sg, BindingContext* binding_context);
 
 // Advance the read transaction version, with change information gathered in info
+// If `recording` is non-null, the instructions which other Realms' handlers
+// need are also recorded into it
 void advance(SharedGroup& sg,
              TransactionChangeInfo& info,
-             SharedGroup::VersionID version=SharedGroup::VersionID{});
+             SharedGroup::VersionID version=SharedGroup::VersionID{},
+             TransactLogRecording* recording=nullptr);
 } // namespace transaction
 } // namespace _impl
 } // namespace realm
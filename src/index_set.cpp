@@ -356,6 +356,23 @@ void IndexSet::add(IndexSet const& other)
     }
 }
 
+void IndexSet::append(size_t index, size_t count)
+{
+    REALM_ASSERT(ends_before(index));
+    REALM_ASSERT(count > 0);
+
+    if (!empty() && m_data.back().end == index) {
+        auto& chunk = m_data.back();
+        chunk.data.back().second += count;
+        chunk.end += count;
+        chunk.count += count;
+        verify();
+    }
+    else {
+        push_back({index, index + count});
+    }
+}
+
 size_t IndexSet::add_shifted(size_t index)
 {
     iterator it = begin(), end = this->end();
@@ -145,10 +145,17 @@ public:
     // Counts the number of indices in the set in the given range
     size_t count(size_t start_index=0, size_t end_index=-1) const;
 
+    // Check if every index in the set is less than the given index
+    bool ends_before(size_t index) const noexcept { return empty() || m_data.back().end <= index; }
+
     // Add an index to the set, doing nothing if it's already present
     void add(size_t index);
     void add(IndexSet const& is);
 
+    // Add the range [index, index + count) in constant time
+    // Precondition: ends_before(index)
+    void append(size_t index, size_t count=1);
+
     // Add an index which has had all of the ranges in the set before it removed
     // Returns the unshifted index
     size_t add_shifted(size_t index);
@@ -28,9 +28,80 @@
 
 #include <realm/link_view.hpp>
 
+#include <algorithm>
+
 using namespace realm;
 using namespace realm::_impl;
 
+namespace {
+// Beyond this many edits, diffing the new contents of a List against the old
+// costs more than it saves and we fall back to setting each entry in place
+const size_t c_max_list_diff_edits = 1000;
+
+struct ListEdit {
+    enum class Kind { Insert, Remove, Set };
+    Kind kind;
+    size_t ndx;
+    size_t target = npos;
+};
+
+// Compute the shortest series of insertions and removals turning `a` into
+// `b` using Myers' O((N+M)D) diff algorithm, or return false if it requires
+// more than `max_edits` edits. The edits are ordered from the end of the
+// list to the start so that each can be applied without adjusting the
+// indices of the ones which follow it.
+bool diff_rows(std::vector<size_t> const& a, std::vector<size_t> const& b,
+               size_t max_edits, std::vector<ListEdit>& edits)
+{
+    ptrdiff_t n = a.size(), m = b.size();
+    ptrdiff_t max_d = std::min<ptrdiff_t>(n + m, max_edits);
+
+    // v[offset + k] is the furthest point reached on diagonal k, and trace[d]
+    // holds v[-d-1...d+1] from before step d for backtracking
+    ptrdiff_t offset = max_d + 1;
+    std::vector<ptrdiff_t> v(2 * offset + 1, 0);
+    std::vector<std::vector<ptrdiff_t>> trace;
+
+    for (ptrdiff_t d = 0; ; ++d) {
+        if (d > max_d)
+            return false;
+        trace.emplace_back(v.begin() + offset - d - 1, v.begin() + offset + d + 2);
+
+        bool done = false;
+        for (ptrdiff_t k = -d; k <= d && !done; k += 2) {
+            ptrdiff_t x = k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])
+                        ? v[offset + k + 1] : v[offset + k - 1] + 1;
+            ptrdiff_t y = x - k;
+            while (x < n && y < m && a[x] == b[y])
+                ++x, ++y;
+            v[offset + k] = x;
+            done = x >= n && y >= m;
+        }
+        if (done)
+            break;
+    }
+
+    ptrdiff_t x = n, y = m;
+    for (ptrdiff_t d = trace.size() - 1; d > 0; --d) {
+        auto prev = [&](ptrdiff_t k) { return trace[d][k + d + 1]; };
+        ptrdiff_t k = x - y;
+        ptrdiff_t prev_k = k == -d || (k != d && prev(k - 1) < prev(k + 1)) ? k + 1 : k - 1;
+        ptrdiff_t prev_x = prev(prev_k);
+        ptrdiff_t prev_y = prev_x - prev_k;
+        while (x > prev_x && y > prev_y)
+            --x, --y;
+
+        if (x == prev_x)
+            edits.push_back({ListEdit::Kind::Insert, size_t(prev_x), b[prev_y]});
+        else
+            edits.push_back({ListEdit::Kind::Remove, size_t(prev_x)});
+        x = prev_x;
+        y = prev_y;
+    }
+    return true;
+}
+} // anonymous namespace
+
 List::List() noexcept = default;
 List::~List() = default;
 
@@ -51,9 +122,8 @@ const ObjectSchema& List::get_object_schema() const
 
     if (!m_object_schema) {
         auto object_type = ObjectStore::object_type_for_table_name(m_link_view->get_target_table().get_name());
-        auto it = m_realm->schema().find(object_type);
-        REALM_ASSERT(it != m_realm->schema().end());
-        m_object_schema = &*it;
+        m_object_schema = m_realm->find_object_schema(object_type);
+        REALM_ASSERT(m_object_schema);
     }
     return *m_object_schema;
 }
@@ -125,7 +195,18 @@ size_t List::find(ConstRow const& row) const
         return not_found;
     }
 
-    return m_link_view->find(row.get_index());
+    size_t row_ndx = row.get_index();
+    auto scan = [&] { return m_link_view->find(row_ndx); };
+
+    // The LinkView can be modified at any point within a write transaction,
+    // but otherwise only changes when the read transaction advances
+    if (m_realm->is_in_transaction()) {
+        m_row_positions.invalidate();
+        return scan();
+    }
+    m_row_positions.set_version(RowPositionIndex::transaction_version(*m_realm));
+    return m_row_positions.find(row_ndx, m_link_view->size(), scan,
+                                [&](size_t ndx) { return m_link_view->get(ndx).get_index(); });
 }
 
 void List::add(size_t target_row_ndx)
@@ -177,6 +258,82 @@ void List::swap(size_t ndx1, size_t ndx2)
     m_link_view->swap(ndx1, ndx2);
 }
 
+void List::assign(std::vector<size_t> const& target_row_ndxs)
+{
+    verify_in_transaction();
+    replace_range(0, m_link_view->size(), target_row_ndxs);
+}
+
+void List::splice(size_t list_ndx, size_t remove_count, std::vector<size_t> const& target_row_ndxs)
+{
+    verify_in_transaction();
+    verify_valid_row(list_ndx, true);
+    if (remove_count > m_link_view->size() - list_ndx) {
+        throw OutOfBoundsIndexException{list_ndx + remove_count, m_link_view->size() + 1};
+    }
+    replace_range(list_ndx, list_ndx + remove_count, target_row_ndxs);
+}
+
+void List::replace_range(size_t begin, size_t end, std::vector<size_t> const& target_row_ndxs)
+{
+    // Entries which are unchanged at the start and end of the range don't
+    // need to be looked at any further
+    std::vector<size_t> old_rows;
+    old_rows.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i)
+        old_rows.push_back(m_link_view->get(i).get_index());
+
+    auto prefix = std::mismatch(old_rows.begin(), old_rows.end(),
+                                target_row_ndxs.begin(), target_row_ndxs.end());
+    size_t prefix_size = prefix.first - old_rows.begin();
+    size_t suffix_size = 0;
+    while (suffix_size < old_rows.size() - prefix_size && suffix_size < target_row_ndxs.size() - prefix_size
+           && old_rows[old_rows.size() - suffix_size - 1] == target_row_ndxs[target_row_ndxs.size() - suffix_size - 1])
+        ++suffix_size;
+
+    old_rows.erase(old_rows.end() - suffix_size, old_rows.end());
+    old_rows.erase(old_rows.begin(), old_rows.begin() + prefix_size);
+    std::vector<size_t> new_rows(target_row_ndxs.begin() + prefix_size, target_row_ndxs.end() - suffix_size);
+    begin += prefix_size;
+
+    std::vector<ListEdit> edits;
+    if (diff_rows(old_rows, new_rows, c_max_list_diff_edits, edits)) {
+        // A removal and an insertion which leave the new row where the old
+        // one was can be done as a single set
+        for (size_t i = 0; i < edits.size(); ++i) {
+            auto& edit = edits[i];
+            if (i + 1 < edits.size()) {
+                auto& next = edits[i + 1];
+                if (edit.kind == ListEdit::Kind::Remove && next.kind == ListEdit::Kind::Insert && next.ndx == edit.ndx) {
+                    m_link_view->set(begin + edit.ndx, next.target);
+                    ++i;
+                    continue;
+                }
+                if (edit.kind == ListEdit::Kind::Insert && next.kind == ListEdit::Kind::Remove && next.ndx + 1 == edit.ndx) {
+                    m_link_view->set(begin + next.ndx, edit.target);
+                    ++i;
+                    continue;
+                }
+            }
+            if (edit.kind == ListEdit::Kind::Insert)
+                m_link_view->insert(begin + edit.ndx, edit.target);
+            else
+                m_link_view->remove(begin + edit.ndx);
+        }
+        return;
+    }
+
+    size_t common = std::min(old_rows.size(), new_rows.size());
+    for (size_t i = 0; i < common; ++i) {
+        if (old_rows[i] != new_rows[i])
+            m_link_view->set(begin + i, new_rows[i]);
+    }
+    for (size_t i = common; i < new_rows.size(); ++i)
+        m_link_view->insert(begin + i, new_rows[i]);
+    for (size_t i = old_rows.size(); i > common; --i)
+        m_link_view->remove(begin + i - 1);
+}
+
 void List::delete_all()
 {
     verify_in_transaction();
@@ -214,14 +371,22 @@ size_t hash<realm::List>::operator()(realm::List const& list) const
 }
 }
 
-NotificationToken List::add_notification_callback(CollectionChangeCallback cb)
+NotificationToken List::add_notification_callback(CollectionChangeCallback cb,
+                                                  std::vector<std::string> const& key_paths,
+                                                  NotificationPriority priority)
 {
     verify_attached();
+    if (m_realm->is_frozen()) {
+        throw InvalidTransactionException("Cannot add notification callbacks to Lists from frozen Realms");
+    }
+    std::vector<size_t> columns;
+    if (!key_paths.empty())
+        columns = CollectionNotifier::columns_for_key_paths(get_object_schema(), key_paths);
     if (!m_notifier) {
         m_notifier = std::make_shared<ListNotifier>(m_link_view, m_realm);
         RealmCoordinator::register_notifier(m_notifier);
     }
-    return {m_notifier, m_notifier->add_callback(std::move(cb))};
+    return {m_notifier, m_notifier->add_callback(std::move(cb), std::move(columns), priority)};
 }
 
 List::OutOfBoundsIndexException::OutOfBoundsIndexException(size_t r, size_t c)
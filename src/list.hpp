@@ -21,12 +21,14 @@
 
 #include "collection_notifications.hpp"
 #include "impl/collection_notifier.hpp"
+#include "impl/row_position_index.hpp"
 
 #include <realm/link_view_fwd.hpp>
 #include <realm/row.hpp>
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace realm {
 using RowExpr = BasicRowExpr<Table>;
@@ -71,6 +73,13 @@ public:
     void set(size_t row_ndx, size_t target_row_ndx);
     void swap(size_t ndx1, size_t ndx2);
 
+    // Replace the contents of the List (or of `remove_count` entries starting
+    // at `list_ndx`) with the given target rows. Only the entries which
+    // actually differ are inserted, removed or set, so replacing a List with
+    // a nearly identical one produces a correspondingly small changeset.
+    void assign(std::vector<size_t> const& target_row_ndxs);
+    void splice(size_t list_ndx, size_t remove_count, std::vector<size_t> const& target_row_ndxs);
+
     void delete_all();
 
     Results sort(SortDescriptor order);
@@ -81,7 +90,11 @@ public:
 
     bool operator==(List const& rgt) const noexcept;
 
-    NotificationToken add_notification_callback(CollectionChangeCallback cb);
+    // See Results::add_notification_callback() for the meaning of `key_paths`
+    // and `priority`
+    NotificationToken add_notification_callback(CollectionChangeCallback cb,
+                                                std::vector<std::string> const& key_paths = {},
+                                                NotificationPriority priority = NotificationPriority::Background);
 
     // These are implemented in object_accessor.hpp
     template <typename ValueType, typename ContextType>
@@ -114,8 +127,10 @@ private:
     mutable const ObjectSchema* m_object_schema = nullptr;
     LinkViewRef m_link_view;
     _impl::CollectionNotifier::Handle<_impl::CollectionNotifier> m_notifier;
+    mutable _impl::RowPositionIndex m_row_positions;
 
     void verify_valid_row(size_t row_ndx, bool insertion = false) const;
+    void replace_range(size_t begin, size_t end, std::vector<size_t> const& target_row_ndxs);
 
     friend struct std::hash<List>;
 };
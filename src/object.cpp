@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "object_accessor.hpp"
+
+#include "impl/object_notifier.hpp"
+#include "impl/realm_coordinator.hpp"
+
+using namespace realm;
+using namespace realm::_impl;
+
+Object::~Object() = default;
+Object::Object(Object const&) = default;
+Object& Object::operator=(Object const&) = default;
+Object::Object(Object&&) = default;
+Object& Object::operator=(Object&&) = default;
+
+NotificationToken Object::add_notification_callback(CollectionChangeCallback callback,
+                                                    std::vector<std::string> const& key_paths,
+                                                    NotificationPriority priority)
+{
+    verify_attached();
+    if (m_realm->is_frozen()) {
+        throw InvalidTransactionException("Cannot add notification callbacks to objects from frozen Realms");
+    }
+    std::vector<size_t> columns;
+    if (!key_paths.empty())
+        columns = CollectionNotifier::columns_for_key_paths(*m_object_schema, key_paths);
+    if (!m_notifier) {
+        m_notifier = std::make_shared<ObjectNotifier>(m_row, m_realm);
+        RealmCoordinator::register_notifier(m_notifier);
+    }
+    return {m_notifier, m_notifier->add_callback(std::move(callback), std::move(columns), priority)};
+}
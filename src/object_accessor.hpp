@@ -32,10 +32,19 @@
 #include <realm/table_view.hpp>
 
 namespace realm {
+    namespace _impl {
+        class ObjectNotifier;
+    }
 
     class Object {
     public:
         Object(SharedRealm r, const ObjectSchema &s, Row o) : m_realm(r), m_object_schema(&s), m_row(o) {}
+        ~Object();
+
+        Object(Object const&);
+        Object& operator=(Object const&);
+        Object(Object&&);
+        Object& operator=(Object&&);
 
         // property getter/setter
         template<typename ValueType, typename ContextType>
@@ -57,10 +66,23 @@ namespace realm {
 
         bool is_valid() const { return m_row.is_attached(); }
 
+        // Add a callback which is called with the changes to this object after
+        // each commit which modifies it. The changes are calculated on the
+        // background worker and reported as a changeset for a collection
+        // containing only this object: `deletions` contains 0 if the object
+        // was deleted, and otherwise `columns` has an entry for each modified
+        // property. If `key_paths` is non-empty, only changes to the named
+        // properties are reported. `priority` is a hint for how urgently the
+        // changes are needed.
+        NotificationToken add_notification_callback(CollectionChangeCallback callback,
+                                                    std::vector<std::string> const& key_paths = {},
+                                                    NotificationPriority priority = NotificationPriority::Background);
+
     private:
         SharedRealm m_realm;
         const ObjectSchema *m_object_schema;
         Row m_row;
+        _impl::CollectionNotifier::Handle<_impl::ObjectNotifier> m_notifier;
 
         template<typename ValueType, typename ContextType>
         inline void set_property_value_impl(ContextType ctx, const Property &property, ValueType value, bool try_update);
@@ -252,15 +274,17 @@ namespace realm {
                 break;
             }
             case PropertyType::Array: {
-                realm::LinkViewRef link_view = m_row.get_linklist(column);
-                link_view->clear();
+                std::vector<size_t> target_rows;
                 if (!Accessor::is_null(ctx, value)) {
                     size_t count = Accessor::list_size(ctx, value);
+                    target_rows.reserve(count);
                     for (size_t i = 0; i < count; i++) {
                         ValueType element = Accessor::list_value_at_index(ctx, value, i);
-                        link_view->add(Accessor::to_object_index(ctx, m_realm, element, property.object_type, try_update));
+                        target_rows.push_back(Accessor::to_object_index(ctx, m_realm, element, property.object_type, try_update));
                     }
                 }
+                // Only write the entries which actually changed
+                List(m_realm, m_row.get_linklist(column)).assign(target_rows);
                 break;
             }
             case PropertyType::LinkingObjects:
@@ -300,7 +324,7 @@ namespace realm {
             case PropertyType::Date:
                 return Accessor::from_timestamp(ctx, m_row.get_timestamp(column));
             case PropertyType::Object: {
-                auto linkObjectSchema = m_realm->schema().find(property.object_type);
+                auto linkObjectSchema = m_realm->find_object_schema(property.object_type);
                 TableRef table = ObjectStore::table_for_object_type(m_realm->read_group(), linkObjectSchema->name);
                 if (m_row.is_null_link(property.table_column)) {
                     return Accessor::null_value(ctx);
@@ -22,12 +22,14 @@
 #include "schema.hpp"
 #include "shared_realm.hpp"
 #include "util/format.hpp"
+#include "util/hash.hpp"
 
 #include <realm/group.hpp>
 #include <realm/table.hpp>
 #include <realm/table_view.hpp>
 #include <realm/util/assert.hpp>
 
+#include <algorithm>
 #include <string.h>
 
 using namespace realm;
@@ -38,6 +40,8 @@ namespace {
 const char * const c_metadataTableName = "metadata";
 const char * const c_versionColumnName = "version";
 const size_t c_versionColumnIndex = 0;
+const char * const c_fingerprintColumnName = "fingerprint";
+const size_t c_fingerprintColumnIndex = 1;
 
 const char * const c_primaryKeyTableName = "pk";
 const char * const c_primaryKeyObjectClassColumnName = "pk_table";
@@ -65,6 +69,11 @@ void create_metadata_tables(Group& group) {
         table->add_empty_row();
         table->set_int(c_versionColumnIndex, c_zeroRowIndex, ObjectStore::NotVersioned);
     }
+    if (table->get_column_count() == c_fingerprintColumnIndex) {
+        // Files written before the fingerprint was stored start out with an
+        // unknown (zero) fingerprint
+        table->add_column(type_Int, c_fingerprintColumnName);
+    }
 }
 
 void set_schema_version(Group& group, uint64_t version) {
@@ -72,6 +81,16 @@ void set_schema_version(Group& group, uint64_t version) {
     table->set_int(c_versionColumnIndex, c_zeroRowIndex, version);
 }
 
+// Record the fingerprint of the schema which the object tables now exactly
+// match, or zero if they may not match any known schema
+void set_schema_fingerprint(Group& group, uint64_t fingerprint) {
+    TableRef table = group.get_table(c_metadataTableName);
+    if (table && table->get_column_count() > c_fingerprintColumnIndex
+        && uint64_t(table->get_int(c_fingerprintColumnIndex, c_zeroRowIndex)) != fingerprint) {
+        table->set_int(c_fingerprintColumnIndex, c_zeroRowIndex, fingerprint);
+    }
+}
+
 template<typename Group>
 auto table_for_object_schema(Group& group, ObjectSchema const& object_schema)
 {
@@ -133,17 +152,22 @@ TableRef create_table(Group& group, ObjectSchema const& object_schema)
     return table;
 }
 
-void copy_property_values(Property const& prop, Table& table)
+// Number of rows copied from each column before moving on to the next column
+// when converting several columns at once. Matches core's default B+-tree leaf
+// size so that each block touches a single leaf of each column.
+const size_t c_copy_block_size = 1000;
+
+// Copy the values in rows [begin, end) from column `col + 1` to column `col`
+void copy_property_values(PropertyType type, Table& table, size_t col, size_t begin, size_t end)
 {
     auto copy_property_values = [&](auto getter, auto setter) {
-        for (size_t i = 0, count = table.size(); i < count; i++) {
+        for (size_t i = begin; i < end; i++) {
             bool is_default = false;
-            (table.*setter)(prop.table_column, i, (table.*getter)(prop.table_column + 1, i),
-                            is_default);
+            (table.*setter)(col, i, (table.*getter)(col + 1, i), is_default);
         }
     };
 
-    switch (prop.type) {
+    switch (type) {
         case PropertyType::Int:
             copy_property_values(&Table::get_int, &Table::set_int);
             break;
@@ -170,12 +194,40 @@ void copy_property_values(Property const& prop, Table& table)
     }
 }
 
+// Convert all of the given properties of a table to nullable at once. The new
+// columns are all inserted up front, the values are copied over in blocks of
+// rows, and then the old columns are all removed, so that the table is only
+// walked once regardless of how many properties are changing.
+void make_properties_optional(Group& group, Table& table, std::vector<Property> properties)
+{
+    // Insert the new columns from the back so that inserting a column doesn't
+    // shift the position of any of the columns which have yet to be inserted
+    std::sort(begin(properties), end(properties),
+              [](auto const& a, auto const& b) { return a.table_column > b.table_column; });
+    for (auto& property : properties) {
+        property.is_nullable = true;
+        insert_column(group, table, property, property.table_column);
+    }
+
+    // Each new column is shifted by the number of new columns before it, and
+    // the old column is always immediately after the new one
+    std::reverse(begin(properties), end(properties));
+    for (size_t i = 0; i < properties.size(); ++i)
+        properties[i].table_column += i;
+
+    for (size_t block_begin = 0, count = table.size(); block_begin < count; block_begin += c_copy_block_size) {
+        size_t block_end = std::min(block_begin + c_copy_block_size, count);
+        for (auto const& property : properties)
+            copy_property_values(property.type, table, property.table_column, block_begin, block_end);
+    }
+
+    for (auto it = properties.rbegin(); it != properties.rend(); ++it)
+        table.remove_column(it->table_column + 1);
+}
+
 void make_property_optional(Group& group, Table& table, Property property)
 {
-    property.is_nullable = true;
-    insert_column(group, table, property, property.table_column);
-    copy_property_values(property, table);
-    table.remove_column(property.table_column + 1);
+    make_properties_optional(group, table, {std::move(property)});
 }
 
 void make_property_required(Group& group, Table& table, Property property)
@@ -185,22 +237,149 @@ void make_property_required(Group& group, Table& table, Property property)
     table.remove_column(property.table_column + 1);
 }
 
+// An open-addressing hash set of 64-bit values. Checking a column for
+// duplicates may insert tens of millions of values, which with a node-based
+// set would mean a heap allocation and several words of overhead per value.
+class FingerprintSet {
+public:
+    FingerprintSet(size_t count)
+    {
+        // Keep the load factor at or below one half
+        size_t capacity = 16;
+        while (capacity < count * 2)
+            capacity *= 2;
+        m_slots.resize(capacity, c_empty);
+    }
+
+    // Returns false if the value was already in the set
+    bool insert(uint64_t value)
+    {
+        if (value == c_empty) {
+            bool inserted = !m_contains_empty;
+            m_contains_empty = true;
+            return inserted;
+        }
+
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = mix(value) & mask; ; i = (i + 1) & mask) {
+            if (m_slots[i] == value)
+                return false;
+            if (m_slots[i] == c_empty) {
+                m_slots[i] = value;
+                return true;
+            }
+        }
+    }
+
+private:
+    static const uint64_t c_empty = 0;
+    std::vector<uint64_t> m_slots;
+    bool m_contains_empty = false;
+
+    // Sequential keys are common, so spread them over the whole table
+    static size_t mix(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        return static_cast<size_t>(value);
+    }
+};
+
+// Check if the column has any duplicate values, stopping at the first one found.
+// Primary key columns always have a search index, so each value is simply
+// looked up in it. Otherwise the values seen so far (or a fingerprint of them
+// for strings) are recorded in a FingerprintSet, and a repeated string
+// fingerprint is confirmed by counting the actual value.
+bool has_duplicate_values(Table const& table, size_t col)
+{
+    size_t count = table.size();
+    bool nullable = table.is_nullable(col);
+    bool indexed = table.has_search_index(col);
+    bool seen_null = false;
+    auto is_duplicate_null = [&] {
+        bool duplicate = seen_null;
+        seen_null = true;
+        return duplicate;
+    };
+
+    switch (table.get_column_type(col)) {
+        case type_Int: {
+            FingerprintSet seen(indexed ? 0 : count);
+            for (size_t row = 0; row < count; ++row) {
+                if (nullable && table.is_null(col, row)) {
+                    if (is_duplicate_null())
+                        return true;
+                    continue;
+                }
+                int64_t value = table.get_int(col, row);
+                if (indexed ? table.count_int(col, value) > 1 : !seen.insert(uint64_t(value)))
+                    return true;
+            }
+            return false;
+        }
+        case type_String: {
+            FingerprintSet seen(indexed ? 0 : count);
+            for (size_t row = 0; row < count; ++row) {
+                StringData value = table.get_string(col, row);
+                if (value.is_null()) {
+                    if (is_duplicate_null())
+                        return true;
+                    continue;
+                }
+                if (indexed ? table.count_string(col, value) > 1
+                            : !seen.insert(util::fnv1a(value)) && table.count_string(col, value) > 1)
+                    return true;
+            }
+            return false;
+        }
+        default:
+            return table.get_distinct_view(col).size() != count;
+    }
+}
+
 void validate_primary_column_uniqueness(Group const& group, StringData object_type, StringData primary_property)
 {
     auto table = ObjectStore::table_for_object_type(group, object_type);
-    if (table->get_distinct_view(table->get_column_index(primary_property)).size() != table->size()) {
+    // Tables with fewer than two rows can't have duplicates
+    if (table->size() < 2) {
+        return;
+    }
+    if (has_duplicate_values(*table, table->get_column_index(primary_property))) {
         throw DuplicatePrimaryKeyValueException(object_type, primary_property);
     }
 }
 
-void validate_primary_column_uniqueness(Group const& group)
+// Validate each of the given (object type, primary key property) pairs, calling
+// `progress` after each one. Smaller tables are checked first so that a
+// duplicate in them is reported without waiting on the larger ones.
+void validate_primary_column_uniqueness(Group const& group,
+                                        std::vector<std::pair<StringData, StringData>> primary_keys,
+                                        ObjectStore::ValidationProgressFunction const& progress)
+{
+    auto table_size = [&](auto const& primary_key) {
+        return ObjectStore::table_for_object_type(group, primary_key.first)->size();
+    };
+    std::sort(begin(primary_keys), end(primary_keys),
+              [&](auto const& a, auto const& b) { return table_size(a) < table_size(b); });
+
+    for (size_t i = 0; i < primary_keys.size(); ++i) {
+        validate_primary_column_uniqueness(group, primary_keys[i].first, primary_keys[i].second);
+        if (progress) {
+            progress(i + 1, primary_keys.size());
+        }
+    }
+}
+
+void validate_primary_column_uniqueness(Group const& group, ObjectStore::ValidationProgressFunction const& progress)
 {
     auto pk_table = group.get_table(c_primaryKeyTableName);
+    std::vector<std::pair<StringData, StringData>> primary_keys;
     for (size_t i = 0, count = pk_table->size(); i < count; ++i) {
-        validate_primary_column_uniqueness(group,
-                                           pk_table->get_string(c_primaryKeyObjectClassColumnIndex, i),
-                                           pk_table->get_string(c_primaryKeyPropertyNameColumnIndex, i));
+        primary_keys.emplace_back(pk_table->get_string(c_primaryKeyObjectClassColumnIndex, i),
+                                  pk_table->get_string(c_primaryKeyPropertyNameColumnIndex, i));
     }
+    validate_primary_column_uniqueness(group, std::move(primary_keys), progress);
 }
 } // anonymous namespace
 
@@ -212,6 +391,19 @@ uint64_t ObjectStore::get_schema_version(Group const& group) {
     return table->get_int(c_versionColumnIndex, c_zeroRowIndex);
 }
 
+uint64_t ObjectStore::get_schema_fingerprint(Group const& group) {
+    ConstTableRef table = group.get_table(c_metadataTableName);
+    if (!table || table->get_column_count() <= c_fingerprintColumnIndex) {
+        return 0;
+    }
+    return table->get_int(c_fingerprintColumnIndex, c_zeroRowIndex);
+}
+
+void ObjectStore::store_schema_fingerprint(Group& group, uint64_t fingerprint) {
+    create_metadata_tables(group);
+    set_schema_fingerprint(group, fingerprint);
+}
+
 StringData ObjectStore::get_primary_key_for_object(Group const& group, StringData object_type) {
     ConstTableRef table = group.get_table(c_primaryKeyTableName);
     if (!table) {
@@ -225,6 +417,7 @@ StringData ObjectStore::get_primary_key_for_object(Group const& group, StringDat
 }
 
 void ObjectStore::set_primary_key_for_object(Group& group, StringData object_type, StringData primary_key) {
+    set_schema_fingerprint(group, 0);
     TableRef table = group.get_table(c_primaryKeyTableName);
 
     // get row or create if new object and populate
@@ -348,6 +541,47 @@ private:
     TableRef m_current_table;
 };
 
+// Accumulates MakePropertyNullable changes for a table so that they can all be
+// applied with a single call to make_properties_optional(). Changes which would
+// observe the columns in their intermediate state (removing columns, changing
+// the indexes on a pending column, or touching a different table) must flush
+// the pending conversions first.
+class NullableColumnBatch {
+public:
+    NullableColumnBatch(Group& g) : m_group(g) { }
+
+    void add(Table& table, Property const& property)
+    {
+        if (&table != m_table.get())
+            flush();
+        m_table = table.get_table_ref();
+        m_properties.push_back(property);
+    }
+
+    // Flush only if there is a pending conversion for the given column
+    void flush(Table& table, size_t col)
+    {
+        if (&table != m_table.get())
+            return;
+        if (std::any_of(begin(m_properties), end(m_properties),
+                        [&](auto const& prop) { return prop.table_column == col; }))
+            flush();
+    }
+
+    void flush()
+    {
+        if (m_table)
+            make_properties_optional(m_group, *m_table, std::move(m_properties));
+        m_properties.clear();
+        m_table.reset();
+    }
+
+private:
+    Group& m_group;
+    TableRef m_table;
+    std::vector<Property> m_properties;
+};
+
 template<typename ErrorType, typename Verifier>
 void verify_no_errors(Verifier&& verifier, std::vector<SchemaChange> const& changes)
 {
@@ -439,9 +673,10 @@ static void create_initial_tables(Group& group, std::vector<SchemaChange> const&
 {
     using namespace schema_change;
     struct Applier {
-        Applier(Group& group) : group{group}, table{group} { }
+        Applier(Group& group) : group{group}, table{group}, nullable{group} { }
         Group& group;
         TableHelper table;
+        NullableColumnBatch nullable;
 
         void operator()(AddTable op) { create_table(group, *op.object); }
 
@@ -451,12 +686,27 @@ static void create_initial_tables(Group& group, std::vector<SchemaChange> const&
         // not-quite-correct files produced by other things and has no obvious
         // downside.
         void operator()(AddProperty op) { add_column(group, table(op.object), *op.property); }
-        void operator()(RemoveProperty op) { table(op.object).remove_column(op.property->table_column); }
-        void operator()(MakePropertyNullable op) { make_property_optional(group, table(op.object), *op.property); }
+        void operator()(MakePropertyNullable op) { nullable.add(table(op.object), *op.property); }
         void operator()(MakePropertyRequired op) { make_property_required(group, table(op.object), *op.property); }
         void operator()(ChangePrimaryKey op) { ObjectStore::set_primary_key_for_object(group, op.object->name, op.property ? StringData{op.property->name} : ""); }
-        void operator()(AddIndex op) { add_index(table(op.object), op.property->table_column); }
-        void operator()(RemoveIndex op) { table(op.object).remove_search_index(op.property->table_column); }
+
+        void operator()(RemoveProperty op)
+        {
+            nullable.flush();
+            table(op.object).remove_column(op.property->table_column);
+        }
+
+        void operator()(AddIndex op)
+        {
+            nullable.flush(table(op.object), op.property->table_column);
+            add_index(table(op.object), op.property->table_column);
+        }
+
+        void operator()(RemoveIndex op)
+        {
+            nullable.flush(table(op.object), op.property->table_column);
+            table(op.object).remove_search_index(op.property->table_column);
+        }
 
         void operator()(ChangePropertyType op)
         {
@@ -468,6 +718,7 @@ static void create_initial_tables(Group& group, std::vector<SchemaChange> const&
     for (auto& change : changes) {
         change.visit(applier);
     }
+    applier.nullable.flush();
 }
 
 static void apply_additive_changes(Group& group, std::vector<SchemaChange> const& changes, bool update_indexes)
@@ -501,34 +752,54 @@ static void apply_pre_migration_changes(Group& group, std::vector<SchemaChange>
 {
     using namespace schema_change;
     struct Applier {
-        Applier(Group& group) : group{group}, table{group} { }
+        Applier(Group& group) : group{group}, table{group}, nullable{group} { }
         Group& group;
         TableHelper table;
+        NullableColumnBatch nullable;
 
         void operator()(AddTable op) { create_table(group, *op.object); }
         void operator()(AddProperty op) { add_column(group, table(op.object), *op.property); }
         void operator()(RemoveProperty) { /* delayed until after the migration */ }
         void operator()(ChangePropertyType op) { replace_column(group, table(op.object), *op.old_property, *op.new_property); }
-        void operator()(MakePropertyNullable op) { make_property_optional(group, table(op.object), *op.property); }
+        void operator()(MakePropertyNullable op) { nullable.add(table(op.object), *op.property); }
         void operator()(MakePropertyRequired op) { make_property_required(group, table(op.object), *op.property); }
         void operator()(ChangePrimaryKey op) { ObjectStore::set_primary_key_for_object(group, op.object->name, op.property ? op.property->name : ""); }
-        void operator()(AddIndex op) { add_index(table(op.object), op.property->table_column); }
-        void operator()(RemoveIndex op) { table(op.object).remove_search_index(op.property->table_column); }
+
+        void operator()(AddIndex op)
+        {
+            nullable.flush(table(op.object), op.property->table_column);
+            add_index(table(op.object), op.property->table_column);
+        }
+
+        void operator()(RemoveIndex op)
+        {
+            nullable.flush(table(op.object), op.property->table_column);
+            table(op.object).remove_search_index(op.property->table_column);
+        }
     } applier{group};
 
     for (auto& change : changes) {
         change.visit(applier);
     }
+    applier.nullable.flush();
 }
 
-static void apply_post_migration_changes(Group& group, std::vector<SchemaChange> const& changes, Schema const& initial_schema)
+// If `validate_primary_keys` is false the caller is responsible for validating
+// the uniqueness of any new primary keys, which lets callers that validate every
+// primary key table afterwards avoid scanning the changed ones twice.
+static void apply_post_migration_changes(Group& group, std::vector<SchemaChange> const& changes,
+                                         Schema const& initial_schema, bool validate_primary_keys,
+                                         ObjectStore::ValidationProgressFunction const& progress = {})
 {
     using namespace schema_change;
     struct Applier {
-        Applier(Group& group, Schema const& initial_schema) : group{group}, initial_schema(initial_schema), table(group) { }
+        Applier(Group& group, Schema const& initial_schema, bool validate_primary_keys)
+        : group{group}, initial_schema(initial_schema), validate_primary_keys(validate_primary_keys), table(group) { }
         Group& group;
         Schema const& initial_schema;
+        bool validate_primary_keys;
         TableHelper table;
+        std::vector<std::pair<StringData, StringData>> new_primary_keys;
 
         void operator()(RemoveProperty op)
         {
@@ -540,8 +811,8 @@ static void apply_post_migration_changes(Group& group, std::vector<SchemaChange>
 
         void operator()(ChangePrimaryKey op)
         {
-            if (op.property) {
-                validate_primary_column_uniqueness(group, op.object->name, op.property->name);
+            if (op.property && validate_primary_keys) {
+                new_primary_keys.emplace_back(op.object->name, op.property->name);
             }
         }
 
@@ -553,23 +824,26 @@ static void apply_post_migration_changes(Group& group, std::vector<SchemaChange>
         void operator()(MakePropertyNullable) { }
         void operator()(MakePropertyRequired) { }
         void operator()(AddProperty) { }
-    } applier{group, initial_schema};
+    } applier{group, initial_schema, validate_primary_keys};
 
     for (auto& change : changes) {
         change.visit(applier);
     }
+    validate_primary_column_uniqueness(group, std::move(applier.new_primary_keys), progress);
 }
 
 void ObjectStore::apply_schema_changes(Group& group, Schema& schema, uint64_t& schema_version,
                                        Schema const& target_schema, uint64_t target_schema_version,
                                        SchemaMode mode, std::vector<SchemaChange> const& changes,
-                                       std::function<void()> migration_function)
+                                       std::function<void()> migration_function,
+                                       ValidationProgressFunction validation_progress)
 {
     create_metadata_tables(group);
 
     if (schema_version == ObjectStore::NotVersioned) {
         create_initial_tables(group, changes);
         set_schema_version(group, target_schema_version);
+        set_schema_fingerprint(group, target_schema.fingerprint());
         schema_version = target_schema_version;
         schema = target_schema;
         set_schema_columns(group, schema);
@@ -578,6 +852,9 @@ void ObjectStore::apply_schema_changes(Group& group, Schema& schema, uint64_t& s
 
     if (mode == SchemaMode::Additive) {
         apply_additive_changes(group, changes, schema_version < target_schema_version);
+        // Additive changes can leave extra columns and stale indexes behind,
+        // so the file may no longer exactly match any schema
+        set_schema_fingerprint(group, changes.empty() ? target_schema.fingerprint() : 0);
 
         if (schema_version < target_schema_version) {
             schema_version = target_schema_version;
@@ -601,7 +878,7 @@ void ObjectStore::apply_schema_changes(Group& group, Schema& schema, uint64_t& s
         try {
             migration_function();
             verify_no_changes_required(schema_from_group(group).compare(schema));
-            validate_primary_column_uniqueness(group);
+            validate_primary_column_uniqueness(group, validation_progress);
         }
         catch (...) {
             schema = move(old_schema);
@@ -611,11 +888,13 @@ void ObjectStore::apply_schema_changes(Group& group, Schema& schema, uint64_t& s
 
         set_schema_columns(group, schema);
         set_schema_version(group, target_schema_version);
+        set_schema_fingerprint(group, target_schema.fingerprint());
         return;
     }
 
     if (schema_version == target_schema_version) {
         apply_non_migration_changes(group, changes);
+        set_schema_fingerprint(group, target_schema.fingerprint());
         schema = target_schema;
         set_schema_columns(group, schema);
         return;
@@ -636,8 +915,8 @@ void ObjectStore::apply_schema_changes(Group& group, Schema& schema, uint64_t& s
 
             // Migration function may have changed the schema, so we need to re-read it
             schema = schema_from_group(group);
-            apply_post_migration_changes(group, schema.compare(target_schema), old_schema);
-            validate_primary_column_uniqueness(group);
+            apply_post_migration_changes(group, schema.compare(target_schema), old_schema, false);
+            validate_primary_column_uniqueness(group, validation_progress);
         }
         catch (...) {
             schema = move(old_schema);
@@ -646,10 +925,11 @@ void ObjectStore::apply_schema_changes(Group& group, Schema& schema, uint64_t& s
         }
     }
     else {
-        apply_post_migration_changes(group, changes, {});
+        apply_post_migration_changes(group, changes, {}, true, validation_progress);
     }
 
     set_schema_version(group, target_schema_version);
+    set_schema_fingerprint(group, target_schema.fingerprint());
     schema_version = target_schema_version;
     schema = target_schema;
     set_schema_columns(group, schema);
@@ -682,6 +962,7 @@ void ObjectStore::set_schema_columns(Group const& group, Schema& schema)
 
 void ObjectStore::delete_data_for_object(Group& group, StringData object_type) {
     if (TableRef table = table_for_object_type(group, object_type)) {
+        set_schema_fingerprint(group, 0);
         group.remove_table(table->get_index_in_group());
         ObjectStore::set_primary_key_for_object(group, object_type, "");
     }
@@ -724,6 +1005,8 @@ void ObjectStore::rename_property(Group& group, Schema& target_schema, StringDat
         throw std::logic_error(util::format("Cannot rename property '%1.%2' because it does not exist.", object_type, old_name));
     }
 
+    set_schema_fingerprint(group, 0);
+
     Property *new_property = table_object_schema.property_for_name(new_name);
     if (!new_property) {
         // New property doesn't exist in the table, which means we're probably
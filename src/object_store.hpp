@@ -47,6 +47,18 @@ public:
     // get the last set schema version
     static uint64_t get_schema_version(Group const& group);
 
+    // get the fingerprint of the schema which apply_schema_changes() last
+    // updated the file to, or zero if the file's tables may not exactly match
+    // any schema (e.g. after additive changes or manual modifications)
+    // note that this can't detect changes made to the tables without going
+    // through the ObjectStore
+    static uint64_t get_schema_fingerprint(Group const& group);
+
+    // store the fingerprint of a schema which the file's tables have been
+    // found to exactly match, adding the metadata column for it if needed
+    // NOTE: must be performed within a write transaction
+    static void store_schema_fingerprint(Group& group, uint64_t fingerprint);
+
     // check if all of the changes in the list can be applied automatically, or
     // throw if any of them require a schema version bump and migration function
     static void verify_no_migration_required(std::vector<SchemaChange> const& changes);
@@ -61,14 +73,21 @@ public:
     // check if changes is empty, and throw an exception if not
     static void verify_no_changes_required(std::vector<SchemaChange> const& changes);
 
+    // called with the number of primary key tables checked for duplicate
+    // values so far and the total number to check
+    using ValidationProgressFunction = std::function<void (size_t validated, size_t total)>;
+
     // updates a Realm from old_schema to the given target schema, creating and updating tables as needed
     // passed in target schema is updated with the correct column mapping
     // optionally runs migration function if schema is out of date
+    // each primary key table is validated at most once per call, reporting
+    // progress to validation_progress after each one
     // NOTE: must be performed within a write transaction
     static void apply_schema_changes(Group& group, Schema& schema, uint64_t& schema_version,
                                      Schema const& target_schema, uint64_t target_schema_version,
                                      SchemaMode mode, std::vector<SchemaChange> const& changes,
-                                     std::function<void()> migration_function={});
+                                     std::function<void()> migration_function={},
+                                     ValidationProgressFunction validation_progress={});
 
     // get a table for an object type
     static realm::TableRef table_for_object_type(Group& group, StringData object_type);
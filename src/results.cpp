@@ -23,10 +23,16 @@
 #include "object_schema.hpp"
 #include "object_store.hpp"
 #include "schema.hpp"
+#include "thread_confined.hpp"
 #include "util/compiler.hpp"
 #include "util/format.hpp"
 
+#include <realm/util/scope_exit.hpp>
+
+#include <algorithm>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 using namespace realm;
 
@@ -148,9 +154,8 @@ const ObjectSchema& Results::get_object_schema() const
 
     if (!m_object_schema) {
         REALM_ASSERT(m_realm);
-        auto it = m_realm->schema().find(get_object_type());
-        REALM_ASSERT(it != m_realm->schema().end());
-        m_object_schema = &*it;
+        m_object_schema = m_realm->find_object_schema(get_object_type());
+        REALM_ASSERT(m_object_schema);
     }
 
     return *m_object_schema;
@@ -266,6 +271,7 @@ void Results::update_tableview(bool wants_notifications)
             if (m_sort) {
                 m_table_view.sort(m_sort);
             }
+            m_row_positions.invalidate();
             m_mode = Mode::TableView;
             REALM_FALLTHROUGH;
         case Mode::TableView:
@@ -304,17 +310,46 @@ size_t Results::index_of(size_t row_ndx)
         case Mode::Table:
             return row_ndx;
         case Mode::LinkView:
-            if (update_linkview())
-                return m_link_view->find(row_ndx);
+            if (update_linkview()) {
+                auto scan = [&] { return m_link_view->find(row_ndx); };
+                if (!use_transaction_version_for_row_positions())
+                    return scan();
+                return m_row_positions.find(row_ndx, m_link_view->size(), scan,
+                                            [&](size_t ndx) { return m_link_view->get(ndx).get_index(); });
+            }
             REALM_FALLTHROUGH;
         case Mode::Query:
-        case Mode::TableView:
+        case Mode::TableView: {
             update_tableview();
-            return m_table_view.find_by_source_ndx(row_ndx);
+            auto scan = [&] { return m_table_view.find_by_source_ndx(row_ndx); };
+            if (m_update_policy == UpdatePolicy::Auto) {
+                m_row_positions.set_version(m_table_view.sync_if_needed());
+            }
+            else if (!use_transaction_version_for_row_positions()) {
+                // Snapshots are never rerun, but their rows can still be
+                // deleted or moved by writes
+                return scan();
+            }
+            return m_row_positions.find(row_ndx, m_table_view.size(), scan, [&](size_t ndx) {
+                return m_table_view.is_row_attached(ndx) ? m_table_view.get_source_ndx(ndx) : npos;
+            });
+        }
     }
     REALM_UNREACHABLE();
 }
 
+bool Results::use_transaction_version_for_row_positions()
+{
+    // Outside of write transactions the rows can only change when the read
+    // transaction advances, but within them they can change at any time
+    if (m_realm->is_in_transaction()) {
+        m_row_positions.invalidate();
+        return false;
+    }
+    m_row_positions.set_version(_impl::RowPositionIndex::transaction_version(*m_realm));
+    return true;
+}
+
 template<typename Int, typename Float, typename Double, typename Timestamp>
 util::Optional<Mixed> Results::aggregate(size_t column, bool return_none_for_empty,
                                          const char* name,
@@ -522,11 +557,93 @@ Results Results::snapshot() &&
     REALM_UNREACHABLE();
 }
 
+void Results::parallel_for_each(size_t partitions, std::function<void (size_t, RowExpr)> fn)
+{
+    validate_read();
+
+    size_t count = size();
+    partitions = std::max<size_t>(1, std::min(partitions, count));
+    size_t partition_size = (count + partitions - 1) / partitions;
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto record_error = [&] {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error)
+            error = std::current_exception();
+    };
+    auto process = [&](Results& results, size_t begin) {
+        try {
+            size_t end = std::min(begin + partition_size, count);
+            for (size_t i = begin; i < end; ++i)
+                fn(i, results.get(i));
+        }
+        catch (...) {
+            record_error();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    auto join_workers = util::make_scope_exit([&]() noexcept {
+        for (auto& worker : workers) {
+            if (worker.joinable())
+                worker.join();
+        }
+    });
+    if (partitions > 1) {
+        // Evaluate the query and sort once here and hand the workers the
+        // positions of the rows in their ranges, rather than having each of
+        // them run it again against its own frozen Realm. Rows deleted since
+        // a snapshot was taken are passed on as detached rows, just as get()
+        // returns them.
+        size_t table_ndx = m_table->get_index_in_group();
+        std::vector<size_t> row_indices;
+        row_indices.reserve(count - partition_size);
+        for (size_t i = partition_size; i < count; ++i) {
+            auto row = get(i);
+            row_indices.push_back(row.is_attached() ? row.get_index() : npos);
+        }
+
+        // Only the version needs to be pinned, so no objects are frozen
+        auto frozen = m_realm->freeze({});
+        workers.reserve(partitions - 1);
+        for (size_t i = 1; i < partitions; ++i) {
+            workers.emplace_back([&, frozen, i] {
+                try {
+                    auto realm = frozen.resolve_realm();
+                    auto& table = *realm->read_group().get_table(table_ndx);
+                    size_t begin = i * partition_size;
+                    size_t end = std::min(begin + partition_size, count);
+                    for (size_t j = begin; j < end; ++j) {
+                        size_t row_ndx = row_indices[j - partition_size];
+                        fn(j, row_ndx == npos ? RowExpr() : table.get(row_ndx));
+                    }
+                }
+                catch (...) {
+                    record_error();
+                }
+            });
+        }
+    }
+
+    // Our read transaction is at the frozen version for as long as the
+    // workers are running, so the first range can be read directly
+    process(*this, 0);
+    for (auto& worker : workers)
+        worker.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
 void Results::prepare_async()
 {
     if (m_realm->config().read_only()) {
         throw InvalidTransactionException("Cannot create asynchronous query for read-only Realms");
     }
+    if (m_realm->is_frozen()) {
+        throw InvalidTransactionException("Cannot create asynchronous query for frozen Realms");
+    }
     if (m_realm->is_in_transaction()) {
         throw InvalidTransactionException("Cannot create asynchronous query while in a write transaction");
     }
@@ -548,10 +665,15 @@ NotificationToken Results::async(std::function<void (std::exception_ptr)> target
     return {m_notifier, m_notifier->add_callback(wrap)};
 }
 
-NotificationToken Results::add_notification_callback(CollectionChangeCallback cb)
+NotificationToken Results::add_notification_callback(CollectionChangeCallback cb,
+                                                     std::vector<std::string> const& key_paths,
+                                                     NotificationPriority priority)
 {
+    std::vector<size_t> columns;
+    if (!key_paths.empty())
+        columns = _impl::CollectionNotifier::columns_for_key_paths(get_object_schema(), key_paths);
     prepare_async();
-    return {m_notifier, m_notifier->add_callback(std::move(cb))};
+    return {m_notifier, m_notifier->add_callback(std::move(cb), std::move(columns), priority)};
 }
 
 bool Results::is_in_table_order() const
@@ -580,6 +702,7 @@ void Results::Internal::set_table_view(Results& results, realm::TableView &&tv)
     }
 
     results.m_table_view = std::move(tv);
+    results.m_row_positions.invalidate();
     results.m_mode = Mode::TableView;
     results.m_has_used_table_view = false;
     REALM_ASSERT(results.m_table_view.is_in_sync());
@@ -22,6 +22,7 @@
 #include "collection_notifications.hpp"
 #include "shared_realm.hpp"
 #include "impl/collection_notifier.hpp"
+#include "impl/row_position_index.hpp"
 
 #include <realm/table_view.hpp>
 #include <realm/util/optional.hpp>
@@ -90,6 +91,7 @@ public:
     util::Optional<RowExpr> last();
 
     // Get the first index of the given row in this results, or not_found
+    // Repeated lookups at the same version are O(1) after the first
     // Throws DetachedAccessorException if row is not attached
     // Throws IncorrectTableException if row belongs to a different table
     size_t index_of(size_t row_ndx);
@@ -108,6 +110,18 @@ public:
     Results snapshot() const &;
     Results snapshot() &&;
 
+    // Call `fn` with the index and row accessor of each row in this Results,
+    // split into up to `partitions` contiguous ranges which are processed
+    // concurrently. The query and sort are evaluated once on the calling
+    // thread, which then processes the first range while worker threads read
+    // the rows in the other ranges from frozen Realms at the same version.
+    // Snapshots are processed as they are, with rows which have been deleted
+    // since the snapshot was taken passed to `fn` as detached rows. Blocks
+    // until every range is done, then rethrows the first exception thrown by
+    // `fn`, if any.
+    // Throws InvalidTransactionException if called in a write transaction
+    void parallel_for_each(size_t partitions, std::function<void (size_t, RowExpr)> fn);
+
     // Get the min/max/average/sum of the given column
     // All but sum() returns none when there are zero matching rows
     // sum() returns 0, except for when it returns none
@@ -171,7 +185,15 @@ public:
     // The query will be run on a background thread and delivered to the callback,
     // and then rerun after each commit (if needed) and redelivered if it changed
     NotificationToken async(std::function<void (std::exception_ptr)> target);
-    NotificationToken add_notification_callback(CollectionChangeCallback cb);
+    // If `key_paths` is non-empty, modifications are only reported for
+    // changes to the named properties of the objects (or to the objects they
+    // link to). If a Results has multiple callbacks, each is notified of
+    // changes to any property which any of the callbacks are interested in.
+    // `priority` is a hint for how urgently the changes are needed; see
+    // NotificationPriority.
+    NotificationToken add_notification_callback(CollectionChangeCallback cb,
+                                                std::vector<std::string> const& key_paths = {},
+                                                NotificationPriority priority = NotificationPriority::Background);
 
     bool wants_background_updates() const { return m_wants_background_updates; }
 
@@ -200,6 +222,7 @@ private:
     SortDescriptor m_sort;
 
     _impl::CollectionNotifier::Handle<_impl::ResultsNotifier> m_notifier;
+    _impl::RowPositionIndex m_row_positions;
 
     Mode m_mode = Mode::Empty;
     UpdatePolicy m_update_policy = UpdatePolicy::Auto;
@@ -208,6 +231,7 @@ private:
 
     void update_tableview(bool wants_notifications = true);
     bool update_linkview();
+    bool use_transaction_version_for_row_positions();
 
     void validate_read() const;
     void validate_write() const;
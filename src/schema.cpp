@@ -20,10 +20,12 @@
 
 #include "object_schema.hpp"
 #include "object_store.hpp"
-#include "object_schema.hpp"
 #include "property.hpp"
 
+#include "util/hash.hpp"
+
 #include <algorithm>
+#include <unordered_map>
 
 using namespace realm;
 
@@ -101,12 +103,42 @@ struct GetRemovedColumn {
 };
 }
 
+namespace {
+// Lookup table from name to property for an ObjectSchema, so that comparing
+// two object schemas is linear in the number of properties rather than doing a
+// linear search for each property. Persisted properties take precedence over
+// computed properties with the same name, as in property_for_name().
+class PropertyIndex {
+public:
+    PropertyIndex(ObjectSchema const& object_schema)
+    {
+        m_properties.reserve(object_schema.persisted_properties.size() + object_schema.computed_properties.size());
+        for (auto& prop : object_schema.persisted_properties)
+            m_properties.emplace(prop.name, &prop);
+        for (auto& prop : object_schema.computed_properties)
+            m_properties.emplace(prop.name, &prop);
+    }
+
+    const Property* find(StringData name) const
+    {
+        auto it = m_properties.find(name);
+        return it == m_properties.end() ? nullptr : it->second;
+    }
+
+private:
+    std::unordered_map<StringData, const Property*, util::StringDataHash> m_properties;
+};
+}
+
 static void compare(ObjectSchema const& existing_schema,
                     ObjectSchema const& target_schema,
                     std::vector<SchemaChange>& changes)
 {
+    PropertyIndex existing_properties(existing_schema);
+    PropertyIndex target_properties(target_schema);
+
     for (auto& current_prop : existing_schema.persisted_properties) {
-        auto target_prop = target_schema.property_for_name(current_prop.name);
+        auto target_prop = target_properties.find(current_prop.name);
 
         if (!target_prop) {
             changes.emplace_back(schema_change::RemoveProperty{&existing_schema, &current_prop});
@@ -136,7 +168,7 @@ static void compare(ObjectSchema const& existing_schema,
     }
 
     for (auto& target_prop : target_schema.persisted_properties) {
-        if (!existing_schema.property_for_name(target_prop.name)) {
+        if (!existing_properties.find(target_prop.name)) {
             changes.emplace_back(schema_change::AddProperty{&existing_schema, &target_prop});
         }
     }
@@ -163,6 +195,36 @@ std::vector<SchemaChange> Schema::compare(Schema const& target_schema) const
     return changes;
 }
 
+uint64_t Schema::fingerprint() const
+{
+    uint64_t hash = util::fnv1a_offset_basis;
+    // Strings are hashed with their null terminator so that adjacent strings
+    // can't run together
+    auto add_string = [&](StringData str) {
+        hash = util::fnv1a(str, hash);
+        hash = util::fnv1a("", 1, hash);
+    };
+    auto add_value = [&](unsigned char value) {
+        hash = util::fnv1a(&value, 1, hash);
+    };
+
+    for (auto const& object_schema : *this) {
+        add_string(object_schema.name);
+        add_string(object_schema.primary_key);
+        for (auto const& prop : object_schema.persisted_properties) {
+            add_string(prop.name);
+            add_value(static_cast<unsigned char>(prop.type));
+            add_string(prop.object_type);
+            add_value(prop.is_primary);
+            add_value(prop.is_nullable);
+            add_value(prop.requires_index());
+        }
+        // Separate the last property of this type from the next type's name
+        add_value(0xff);
+    }
+    return hash ? hash : 1;
+}
+
 void Schema::copy_table_columns_from(realm::Schema const& other)
 {
     for (auto& source_schema : other) {
@@ -19,6 +19,7 @@
 #ifndef REALM_SCHEMA_HPP
 #define REALM_SCHEMA_HPP
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -58,6 +59,11 @@ public:
     // Get the changes which must be applied to this schema to produce the passed-in schema
     std::vector<SchemaChange> compare(Schema const&) const;
 
+    // Get a stable hash of everything about this schema which affects the
+    // layout of the file (types, persisted properties, nullability, indexes
+    // and primary keys). Never returns zero.
+    uint64_t fingerprint() const;
+
     void copy_table_columns_from(Schema const&);
 
     friend bool operator==(Schema const&, Schema const&);
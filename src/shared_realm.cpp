@@ -33,6 +33,14 @@
 #include <realm/history.hpp>
 #include <realm/util/scope_exit.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+
 using namespace realm;
 using namespace realm::_impl;
 
@@ -54,9 +62,11 @@ void Realm::init(std::shared_ptr<_impl::RealmCoordinator> coordinator)
         m_schema_version = coordinator->get_schema_version();
     }
     else {
-        // otherwise get the schema from the group
+        // otherwise the schema is read from the group as it's needed: by
+        // update_schema() below if the file's stored schema fingerprint
+        // doesn't match, or one class at a time by find_object_schema()
         m_schema_version = ObjectStore::get_schema_version(read_group());
-        m_schema = ObjectStore::schema_from_group(read_group());
+        m_schema_is_partial = true;
 
         if (m_shared_group) {
             m_schema_transaction_version = m_shared_group->get_version_of_current_transaction().version;
@@ -149,6 +159,10 @@ void Realm::open_with_config(const Config& config,
             SharedGroupOptions options;
             options.durability = config.in_memory ? SharedGroupOptions::Durability::MemOnly :
                                                     SharedGroupOptions::Durability::Full;
+#ifdef REALM_ASYNC_DAEMON
+            if (!config.in_memory && config.durability == Config::Durability::Deferred)
+                options.durability = SharedGroupOptions::Durability::Async;
+#endif
             options.encryption_key = config.encryption_key.data();
             options.allow_file_format_upgrade = !config.disable_format_upgrade;
             options.upgrade_callback = [&](int from_version, int to_version) {
@@ -197,20 +211,55 @@ void Realm::set_schema(Schema schema, uint64_t version)
 bool Realm::read_schema_from_group_if_needed()
 {
     // schema of read-only Realms can't change
-    if (m_read_only_group)
+    if (m_read_only_group) {
+        if (m_schema_is_partial) {
+            m_schema = ObjectStore::schema_from_group(*m_read_only_group);
+            m_schema_is_partial = false;
+        }
         return false;
+    }
 
     Group& group = read_group();
     auto current_version = m_shared_group->get_version_of_current_transaction().version;
-    if (m_schema_transaction_version == current_version)
+    if (m_schema_transaction_version == current_version && !m_schema_is_partial)
         return false;
 
     m_schema = ObjectStore::schema_from_group(group);
     m_schema_version = ObjectStore::get_schema_version(group);
     m_schema_transaction_version = current_version;
+    m_schema_is_partial = false;
     return true;
 }
 
+Schema const& Realm::schema() const
+{
+    if (m_schema_is_partial) {
+        const_cast<Realm*>(this)->read_schema_from_group_if_needed();
+    }
+    return m_schema;
+}
+
+ObjectSchema const* Realm::find_object_schema(StringData object_type) const
+{
+    if (!m_schema_is_partial) {
+        auto it = m_schema.find(object_type);
+        return it == m_schema.end() ? nullptr : &*it;
+    }
+
+    auto& partial_object_schemas = const_cast<Realm*>(this)->m_partial_object_schemas;
+    std::string name(object_type);
+    auto it = partial_object_schemas.find(name);
+    if (it != partial_object_schemas.end())
+        return it->second.get();
+
+    Group& group = const_cast<Realm*>(this)->read_group();
+    if (!ObjectStore::table_for_object_type(group, object_type))
+        return nullptr;
+    auto& object_schema = partial_object_schemas[std::move(name)];
+    object_schema = std::make_unique<ObjectSchema>(group, object_type);
+    return object_schema.get();
+}
+
 void Realm::reset_file_if_needed(Schema const& schema, uint64_t version, std::vector<SchemaChange>& required_changes)
 {
     if (m_schema_version == ObjectStore::NotVersioned)
@@ -233,9 +282,63 @@ void Realm::reset_file_if_needed(Schema const& schema, uint64_t version, std::ve
     required_changes = m_schema.compare(schema);
 }
 
+bool Realm::set_schema_from_fingerprint(Schema& schema, uint64_t version, uint64_t fingerprint)
+{
+    Group& group = read_group();
+    if (ObjectStore::get_schema_version(group) != version)
+        return false;
+    auto stored_fingerprint = ObjectStore::get_schema_fingerprint(group);
+    if (!stored_fingerprint || stored_fingerprint != fingerprint)
+        return false;
+
+    // Older versions of the library, sync and direct use of core can all
+    // modify the tables without clearing the fingerprint, so check that each
+    // column still matches its property and fall back to comparing the full
+    // schemas if any of them doesn't
+    for (auto& object_schema : schema) {
+        auto table = ObjectStore::table_for_object_type(group, object_schema.name);
+        if (!table || table->get_column_count() != object_schema.persisted_properties.size())
+            return false;
+        for (auto& property : object_schema.persisted_properties) {
+            size_t col = table->get_column_index(property.name);
+            if (col == npos)
+                return false;
+            auto type = PropertyType(table->get_column_type(col));
+            if (type != property.type)
+                return false;
+            if ((table->is_nullable(col) || type == PropertyType::Object) != property.is_nullable)
+                return false;
+            if (type == PropertyType::Object || type == PropertyType::Array) {
+                auto target = ObjectStore::object_type_for_table_name(table->get_link_target(col)->get_name());
+                if (target != StringData(property.object_type))
+                    return false;
+            }
+            property.table_column = col;
+        }
+    }
+
+    m_schema = schema;
+    m_schema_version = version;
+    m_schema_is_partial = false;
+    if (m_shared_group)
+        m_schema_transaction_version = m_shared_group->get_version_of_current_transaction().version;
+    m_coordinator->update_schema(m_schema, version);
+    return true;
+}
+
 void Realm::update_schema(Schema schema, uint64_t version, MigrationFunction migration_function)
 {
+    if (m_frozen) {
+        throw InvalidTransactionException("Can't update the schema of a frozen Realm.");
+    }
     schema.validate();
+
+    // If the file was last updated to exactly this schema there's no need to
+    // read the schema from the file and compare them
+    uint64_t fingerprint = schema.fingerprint();
+    if (set_schema_from_fingerprint(schema, version, fingerprint))
+        return;
+
     read_schema_from_group_if_needed();
     std::vector<SchemaChange> required_changes = m_schema.compare(schema);
 
@@ -306,8 +409,18 @@ void Realm::update_schema(Schema schema, uint64_t version, MigrationFunction mig
     // that means that write transactions would block opening Realms in other processes
     if (read_schema_from_group_if_needed()) {
         required_changes = m_schema.compare(schema);
-        if (no_changes_required())
+        if (no_changes_required()) {
+            // Files which were created before fingerprints were stored or
+            // which were last changed additively have none. Opening a file
+            // which matches doesn't commit just to store one, but as a write
+            // transaction is already open here it can be stored for free.
+            if (required_changes.empty() && version == m_schema_version
+                && ObjectStore::get_schema_fingerprint(read_group()) != fingerprint) {
+                ObjectStore::store_schema_fingerprint(read_group(), fingerprint);
+                commit_transaction();
+            }
             return;
+        }
     }
 
     bool additive = m_config.schema_mode == SchemaMode::Additive;
@@ -322,11 +435,13 @@ void Realm::update_schema(Schema schema, uint64_t version, MigrationFunction mig
             migration_function(old_realm, shared_from_this(), m_schema);
         };
         ObjectStore::apply_schema_changes(read_group(), m_schema, m_schema_version,
-                                          schema, version, m_config.schema_mode, required_changes, wrapper);
+                                          schema, version, m_config.schema_mode, required_changes, wrapper,
+                                          m_config.primary_key_validation_progress_function);
     }
     else {
         ObjectStore::apply_schema_changes(read_group(), m_schema, m_schema_version,
-                                          schema, version, m_config.schema_mode, required_changes);
+                                          schema, version, m_config.schema_mode, required_changes, {},
+                                          m_config.primary_key_validation_progress_function);
         REALM_ASSERT_DEBUG(additive || (required_changes = ObjectStore::schema_from_group(read_group()).compare(schema)).empty());
     }
 
@@ -352,11 +467,14 @@ static void check_read_write(Realm *realm)
     if (realm->config().read_only()) {
         throw InvalidTransactionException("Can't perform transactions on read-only Realms.");
     }
+    if (realm->is_frozen()) {
+        throw InvalidTransactionException("Can't perform transactions on frozen Realms.");
+    }
 }
 
 void Realm::verify_thread() const
 {
-    if (m_thread_id != std::this_thread::get_id()) {
+    if (m_thread_confined && m_thread_id != std::this_thread::get_id()) {
         throw IncorrectThreadException();
     }
 }
@@ -402,6 +520,8 @@ void Realm::commit_transaction()
 
     transaction::commit(*m_shared_group, m_binding_context.get());
     m_coordinator->send_commit_notifications();
+    // Deliver notifications for the commit before waiting on any sync
+    m_coordinator->did_commit();
 }
 
 void Realm::cancel_transaction()
@@ -416,6 +536,59 @@ void Realm::cancel_transaction()
     transaction::cancel(*m_shared_group, m_binding_context.get());
 }
 
+void Realm::enqueue_write(std::function<void (SharedRealm)> write,
+                          std::function<void (std::exception_ptr)> completion)
+{
+    check_read_write(this);
+    verify_thread();
+
+    if (is_in_transaction()) {
+        throw InvalidTransactionException("Cannot queue a write while in a write transaction");
+    }
+
+    m_coordinator->enqueue_write(*this, std::move(write), std::move(completion));
+}
+
+struct Realm::AsyncWriteCompletions {
+    std::mutex mutex;
+    std::vector<std::pair<std::function<void (std::exception_ptr)>, std::exception_ptr>> ready;
+};
+
+void Realm::async_write(std::function<void (SharedRealm)> write,
+                        std::function<void (std::exception_ptr)> completion)
+{
+    check_read_write(this);
+    verify_thread();
+
+    if (!completion) {
+        m_coordinator->enqueue_background_write(std::move(write), nullptr);
+        return;
+    }
+
+    if (!m_async_write_completions) {
+        m_async_write_completions = std::make_shared<AsyncWriteCompletions>();
+    }
+    std::weak_ptr<AsyncWriteCompletions> weak_completions = m_async_write_completions;
+    std::weak_ptr<_impl::RealmCoordinator> weak_coordinator = m_coordinator;
+    Realm* realm = this;
+    m_coordinator->enqueue_background_write(std::move(write), [=](std::exception_ptr error) {
+        auto completions = weak_completions.lock();
+        if (!completions) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(completions->mutex);
+            completions->ready.emplace_back(completion, error);
+        }
+        // Wake up this Realm's thread directly rather than relying on the
+        // commit notification, which isn't sent for a failed write or when
+        // automatic change notifications are disabled
+        if (auto coordinator = weak_coordinator.lock()) {
+            coordinator->notify_realm(*realm);
+        }
+    });
+}
+
 void Realm::invalidate()
 {
     verify_thread();
@@ -432,6 +605,15 @@ void Realm::invalidate()
     m_group = nullptr;
 }
 
+void Realm::flush()
+{
+    // Frozen Realms never commit, and closed ones no longer have a coordinator
+    if (m_config.read_only() || m_config.in_memory || m_frozen || !m_coordinator) {
+        return;
+    }
+    m_coordinator->flush();
+}
+
 bool Realm::compact()
 {
     verify_thread();
@@ -439,12 +621,15 @@ bool Realm::compact()
     if (m_config.read_only()) {
         throw InvalidTransactionException("Can't compact a read-only Realm");
     }
+    if (m_frozen) {
+        throw InvalidTransactionException("Can't compact a frozen Realm");
+    }
     if (is_in_transaction()) {
         throw InvalidTransactionException("Can't compact a Realm within a write transaction");
     }
 
     Group& group = read_group();
-    for (auto &object_schema : m_schema) {
+    for (auto &object_schema : schema()) {
         ObjectStore::table_for_object_type(group, object_schema.name)->optimize();
     }
     m_shared_group->end_read();
@@ -467,14 +652,170 @@ void Realm::write_copy(StringData path, BinaryData key)
     }
 }
 
+namespace {
+// A streambuf which writes to a newly created file in fixed-size chunks,
+// sleeping between them as needed to stay under the rate limit and checking
+// for cancellation before each one and while sleeping
+class ThrottledFileBuffer : public std::streambuf {
+public:
+    ThrottledFileBuffer(util::File& file, Realm::WriteCopyOptions const& options, uint64_t estimated_size,
+                        std::atomic<bool> const& cancelled)
+    : m_file(file), m_options(options), m_estimated_size(estimated_size), m_cancelled(cancelled)
+    , m_start(std::chrono::steady_clock::now())
+    {
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        write_buffer();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        write_buffer();
+        return 0;
+    }
+
+private:
+    std::array<char, 64 * 1024> m_buffer;
+    util::File& m_file;
+    Realm::WriteCopyOptions const& m_options;
+    uint64_t m_estimated_size;
+    std::atomic<bool> const& m_cancelled;
+    uint64_t m_written = 0;
+    std::chrono::steady_clock::time_point m_start;
+
+    void check_cancelled()
+    {
+        if (m_cancelled || (m_options.should_cancel && m_options.should_cancel()))
+            throw WriteCopyCancelledException();
+    }
+
+    void write_buffer()
+    {
+        size_t size = pptr() - pbase();
+        if (size == 0)
+            return;
+        check_cancelled();
+
+        if (m_options.max_bytes_per_second) {
+            using namespace std::chrono;
+            auto elapsed = duration<double>(double(m_written + size) / m_options.max_bytes_per_second);
+            auto deadline = m_start + duration_cast<steady_clock::duration>(elapsed);
+            // Sleep in short steps so that cancelling doesn't have to wait out
+            // the rest of the delay
+            while (steady_clock::now() < deadline) {
+                std::this_thread::sleep_until(std::min(deadline, steady_clock::now() + milliseconds(50)));
+                check_cancelled();
+            }
+        }
+
+        m_file.write(pbase(), size);
+        m_written += size;
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+
+        if (m_options.progress)
+            m_options.progress(m_written, std::max(m_written, m_estimated_size));
+    }
+};
+} // anonymous namespace
+
+void Realm::write_copy_async(std::string path, BinaryData key, WriteCopyOptions options,
+                             std::function<void (std::exception_ptr)> completion)
+{
+    if (key.data() && key.size() != 64) {
+        throw InvalidEncryptionKeyException();
+    }
+    verify_thread();
+
+    // Pin the current version by beginning a read transaction at it on a new
+    // SharedGroup, which is then handed off to the background thread
+    std::unique_ptr<Replication> history;
+    std::unique_ptr<SharedGroup> shared_group;
+    std::unique_ptr<Group> read_only_group;
+    Group const* group;
+    size_t estimated_size = 0;
+    if (m_config.read_only()) {
+        open_with_config(m_config, history, shared_group, read_only_group, nullptr);
+        group = read_only_group.get();
+    }
+    else {
+        read_group();
+        auto version = m_shared_group->get_version_of_current_transaction();
+        open_with_config(m_config, history, shared_group, read_only_group, nullptr);
+        group = &shared_group->begin_read(version);
+        size_t free_space = 0;
+        shared_group->get_stats(free_space, estimated_size);
+    }
+
+    m_coordinator->run_background_task([=, history = std::move(history), shared_group = std::move(shared_group),
+                                        read_only_group = std::move(read_only_group),
+                                        encryption_key = std::vector<char>(key.data(), key.data() + key.size())](std::atomic<bool> const& cancelled) mutable {
+        std::exception_ptr error;
+        bool created = false;
+        try {
+            try {
+                if (!encryption_key.empty()) {
+                    group->write(path, encryption_key.data());
+                }
+                else {
+                    util::File file;
+                    file.open(path, util::File::access_ReadWrite, util::File::create_Must, 0);
+                    created = true;
+
+                    ThrottledFileBuffer buffer(file, options, estimated_size, cancelled);
+                    std::ostream out(&buffer);
+                    out.exceptions(std::ios::badbit | std::ios::failbit);
+                    group->write(out);
+                    out.flush();
+                }
+            }
+            catch (WriteCopyCancelledException const&) {
+                throw;
+            }
+            catch (...) {
+                translate_file_exception(path);
+            }
+        }
+        catch (...) {
+            error = std::current_exception();
+            if (created)
+                util::File::try_remove(path);
+        }
+
+        // Release the pinned version before reporting completion
+        shared_group.reset();
+        history.reset();
+        read_only_group.reset();
+        if (completion)
+            completion(error);
+    });
+}
+
 void Realm::notify()
 {
-    if (is_closed()) {
+    // Frozen Realms never advance, and may be in use on another thread
+    if (is_closed() || m_frozen) {
         return;
     }
 
     verify_thread();
 
+    // Grab the completed async writes before advancing, so that when
+    // auto-refresh advances to the latest version it includes all of them
+    std::vector<std::pair<std::function<void (std::exception_ptr)>, std::exception_ptr>> completed_writes;
+    if (m_async_write_completions) {
+        std::lock_guard<std::mutex> lock(m_async_write_completions->mutex);
+        completed_writes.swap(m_async_write_completions->ready);
+    }
+
     if (m_shared_group->has_changed()) { // Throws
         if (m_binding_context) {
             m_binding_context->changes_available();
@@ -491,6 +832,10 @@ void Realm::notify()
     else {
         m_coordinator->process_available_async(*this);
     }
+
+    for (auto& completion : completed_writes) {
+        completion.first(completion.second);
+    }
 }
 
 bool Realm::refresh()
@@ -522,7 +867,7 @@ bool Realm::refresh()
 
 bool Realm::can_deliver_notifications() const noexcept
 {
-    if (m_config.read_only()) {
+    if (m_config.read_only() || m_frozen) {
         return false;
     }
 
@@ -607,6 +952,9 @@ Realm::HandoverPackage Realm::package_for_handover(std::vector<AnyThreadConfined
     if (is_in_transaction()) {
         throw InvalidTransactionException("Cannot package handover during a write transaction.");
     }
+    if (m_frozen) {
+        throw InvalidTransactionException("Cannot package handover from a frozen Realm.");
+    }
 
     HandoverPackage handover;
     auto version_id = m_shared_group->pin_version();
@@ -640,6 +988,9 @@ std::vector<AnyThreadConfined> Realm::accept_handover(Realm::HandoverPackage han
     if (is_in_transaction()) {
         throw InvalidTransactionException("Cannot accept handover during a write transaction.");
     }
+    if (m_frozen) {
+        throw InvalidTransactionException("Cannot accept handover into a frozen Realm.");
+    }
 
     // Ensure we're on the same version as the handover
     if (!m_group) {
@@ -673,5 +1024,134 @@ std::vector<AnyThreadConfined> Realm::accept_handover(Realm::HandoverPackage han
     return objects;
 }
 
+struct Realm::FrozenPackage::State {
+    SharedGroup::VersionID version;
+
+    // The source Realm holds the frozen objects which each thread's copies
+    // are exported from. It is never registered with the coordinator and is
+    // only ever used with the mutex held, so it isn't confined to a thread.
+    std::mutex mutex;
+    SharedRealm source_realm;
+    std::vector<AnyThreadConfined> source_objects;
+    std::vector<std::pair<std::thread::id, WeakRealm>> thread_realms;
+
+    // The config which each thread's frozen Realm is opened with
+    Realm::Config config;
+
+    static Realm::Config frozen_config(Realm const& parent)
+    {
+        Realm::Config config = parent.m_config;
+        config.cache = false;
+        config.schema = util::none;
+        config.migration_function = nullptr;
+        return config;
+    }
+
+    // Set up a Realm opened with frozen_config() to read from the same version
+    // as `parent`, copying its schema rather than reading it from the group
+    static void make_frozen(Realm& realm, Realm const& parent, SharedGroup::VersionID version)
+    {
+        // Frozen Realms share the parent's coordinator so that functions such
+        // as flush() work, but aren't registered with it as they never
+        // receive notifications
+        realm.m_coordinator = parent.m_coordinator;
+        realm.m_schema = parent.m_schema;
+        realm.m_schema_is_partial = parent.m_schema_is_partial;
+        realm.m_schema_version = parent.m_schema_version;
+        realm.m_frozen = true;
+        realm.m_auto_refresh = false;
+        realm.m_group = &const_cast<Group&>(realm.m_shared_group->begin_read(version));
+        realm.m_schema_transaction_version = version.version;
+    }
+
+    // Must be called with the mutex held
+    SharedRealm existing_realm_for_thread(std::thread::id thread_id)
+    {
+        SharedRealm realm;
+        for (size_t i = 0; i < thread_realms.size(); ++i) {
+            if (auto r = thread_realms[i].second.lock()) {
+                if (thread_realms[i].first == thread_id)
+                    realm = std::move(r);
+                continue;
+            }
+            thread_realms[i] = std::move(thread_realms.back());
+            thread_realms.pop_back();
+            --i;
+        }
+        return realm;
+    }
+};
+
+Realm::FrozenPackage Realm::freeze(std::vector<AnyThreadConfined> objects_to_freeze)
+{
+    verify_thread();
+    if (!m_shared_group) {
+        throw InvalidTransactionException("Cannot freeze objects from a read-only Realm.");
+    }
+    if (is_in_transaction()) {
+        throw InvalidTransactionException("Cannot freeze objects during a write transaction.");
+    }
+
+    auto state = std::make_shared<FrozenPackage::State>();
+    read_group();
+    state->version = m_shared_group->get_version_of_current_transaction();
+    // The source Realm's read transaction keeps the version pinned for as
+    // long as the package is alive
+    state->config = FrozenPackage::State::frozen_config(*this);
+    state->source_realm = Realm::make_shared_realm(state->config);
+    FrozenPackage::State::make_frozen(*state->source_realm, *this, state->version);
+    state->source_realm->m_thread_confined = false;
+
+    state->source_objects.reserve(objects_to_freeze.size());
+    for (auto& object : objects_to_freeze) {
+        REALM_ASSERT(object.get_realm().get() == this);
+        state->source_objects.push_back(object.export_for_handover().import_from_handover(state->source_realm));
+    }
+
+    FrozenPackage package;
+    package.m_state = std::move(state);
+    return package;
+}
+
+size_t Realm::FrozenPackage::size() const noexcept
+{
+    return m_state ? m_state->source_objects.size() : 0;
+}
+
+SharedRealm Realm::FrozenPackage::resolve_realm() const
+{
+    if (!m_state) {
+        throw std::logic_error("Cannot resolve an empty frozen package.");
+    }
+
+    auto thread_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    auto realm = m_state->existing_realm_for_thread(thread_id);
+    if (!realm) {
+        // Opening the file is the slow part, so don't make other threads
+        // resolving at the same time wait on it
+        lock.unlock();
+        realm = Realm::make_shared_realm(m_state->config);
+        lock.lock();
+        State::make_frozen(*realm, *m_state->source_realm, m_state->version);
+        m_state->thread_realms.emplace_back(thread_id, realm);
+    }
+    return realm;
+}
+
+std::vector<AnyThreadConfined> Realm::FrozenPackage::resolve() const
+{
+    auto realm = resolve_realm();
+    // The source objects belong to the shared source Realm, so they can only
+    // be exported with the lock held
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    std::vector<AnyThreadConfined> objects;
+    objects.reserve(m_state->source_objects.size());
+    for (auto& object : m_state->source_objects) {
+        objects.push_back(object.export_for_handover().import_from_handover(realm));
+    }
+    return objects;
+}
+
 MismatchedConfigException::MismatchedConfigException(StringData message, StringData path)
 : std::logic_error(util::format(message.data(), path)) { }
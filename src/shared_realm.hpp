@@ -23,14 +23,17 @@
 
 #include <realm/util/optional.hpp>
 
+#include <chrono>
 #include <memory>
 #include <thread>
+#include <unordered_map>
 
 namespace realm {
 class AnyThreadConfined;
 class BinaryData;
 class BindingContext;
 class Group;
+class ObjectSchema;
 class Realm;
 class Replication;
 class SharedGroup;
@@ -44,6 +47,7 @@ namespace _impl {
     class ListNotifier;
     class RealmCoordinator;
     class ResultsNotifier;
+    class RowPositionIndex;
 }
 
 // How to handle update_schema() being called on a file which has
@@ -107,6 +111,7 @@ enum class SchemaMode : uint8_t {
 
 class Realm : public std::enable_shared_from_this<Realm> {
 public:
+    class FrozenPackage;
     class HandoverPackage;
 
     // A callback function to be called during a migration for Automatic and
@@ -125,6 +130,26 @@ public:
         bool in_memory = false;
         SchemaMode schema_mode = SchemaMode::Automatic;
 
+        // Full syncs each commit to disk before commit_transaction() returns.
+        // Deferred leaves syncing to a background process, so a commit is
+        // safe from the process crashing once it returns but the most recent
+        // ones may be lost if the OS crashes or the device loses power. Every
+        // Realm instance for a file must use the same durability, and it's
+        // ignored for in-memory Realms. Deferred needs core's async commit
+        // daemon (REALM_ASYNC_DAEMON); without it each commit is synced just
+        // as with Full, and the flush policy below has no effect.
+        enum class Durability {
+            Full,
+            Deferred
+        };
+        Durability durability = Durability::Full;
+        // With Deferred durability, sync the file to disk after this many
+        // commits have been made since the last sync. Zero to disable.
+        size_t flush_after_commits = 0;
+        // With Deferred durability, sync the file to disk when committing if
+        // it's been at least this long since the last sync. Zero to disable.
+        std::chrono::milliseconds flush_interval{0};
+
         // Optional schema for the file.
         // If the schema and schema version are supplied, update_schema() is
         // called with the supplied schema, version and migration function when
@@ -132,9 +157,22 @@ public:
         util::Optional<Schema> schema;
         uint64_t schema_version = -1;
         MigrationFunction migration_function;
+        // Called during migrations after each table with a primary key has
+        // been checked for duplicate values, with the number of tables checked
+        // so far and the total number which will be checked.
+        std::function<void (size_t validated, size_t total)> primary_key_validation_progress_function;
 
         bool read_only() const { return schema_mode == SchemaMode::ReadOnly; }
 
+        // Called when this process first opens the Realm file (or reopens it
+        // after every instance for it was closed), before anything else in
+        // the process has it open, with the total size of the file and the
+        // number of bytes of it which are in use. If it returns true, the
+        // file is compacted before it's used. Compaction needs exclusive
+        // access to the file, so if another process has it open this does
+        // nothing and the file is used as-is, with no error reported.
+        std::function<bool (uint64_t total_bytes, uint64_t used_bytes)> should_compact_on_launch_function;
+
         // The following are intended for internal/testing purposes and
         // should not be publicly exposed in binding APIs
 
@@ -168,7 +206,12 @@ public:
     static uint64_t get_schema_version(Config const& config);
 
     Config const& config() const { return m_config; }
-    Schema const& schema() const { return m_schema; }
+    // Realms opened without a schema read the classes in the file lazily, so
+    // the first call to this reads every class which hasn't been read yet
+    Schema const& schema() const;
+    // Look up a single class, or return null if it isn't in the schema. This
+    // reads only the requested class if the full schema hasn't been read yet.
+    ObjectSchema const* find_object_schema(StringData object_type) const;
     uint64_t schema_version() const { return m_schema_version; }
 
     void begin_transaction();
@@ -177,6 +220,41 @@ public:
     bool is_in_transaction() const noexcept;
     bool is_in_read_transaction() const { return !!m_group; }
 
+    // Frozen Realms are pinned to a single version and can never be
+    // refreshed, written to or deliver notifications
+    bool is_frozen() const noexcept { return m_frozen; }
+
+    // Queue a write to be committed in a single write transaction along with
+    // every other write queued on this file at the same time, from any
+    // thread, and then call `completion` with the error thrown by the write
+    // or the commit, if any. Each write is run exactly once. If a write
+    // throws, the transaction is rolled back, so every write which had
+    // already run in it is failed with that error too, and the writes queued
+    // after it are committed in a new transaction.
+    //
+    // If no queued writes are in progress, the calling thread performs the
+    // first few batches of them with this Realm (always including this one),
+    // and any still queued after that are performed on a background thread;
+    // otherwise this returns immediately. Either way `write` and `completion`
+    // may be called on another thread, so they must not use thread-confined
+    // objects from the calling thread. An exception thrown by a completion
+    // handler called on this thread is rethrown from here after the batches
+    // have been performed, rather than abandoning the rest of the queue.
+    void enqueue_write(std::function<void (SharedRealm)> write,
+                       std::function<void (std::exception_ptr)> completion = nullptr);
+
+    // Queue a write in the same way as enqueue_write(), but never perform it
+    // on the calling thread: if no queued writes are in progress they are
+    // performed on a background thread, so this never waits for the write
+    // lock or for the commit to be made durable. `completion` is called on
+    // this thread from notify() once the write has been committed or has
+    // failed. This Realm's event loop is signalled to call notify() even if
+    // automatic change notifications are disabled, but on platforms with no
+    // event loop integration the binding must call notify() itself, as it
+    // must to deliver any other notification.
+    void async_write(std::function<void (SharedRealm)> write,
+                     std::function<void (std::exception_ptr)> completion = nullptr);
+
     bool refresh();
     void set_auto_refresh(bool auto_refresh) { m_auto_refresh = auto_refresh; }
     bool auto_refresh() const { return m_auto_refresh; }
@@ -184,8 +262,37 @@ public:
 
     void invalidate();
     bool compact();
+    // Sync everything committed to this Realm file so far to disk, from any
+    // thread or Realm instance for the file. Only needed with Deferred
+    // durability, as Full durability syncs each commit. Does nothing for
+    // read-only, in-memory, frozen or closed Realms.
+    void flush();
     void write_copy(StringData path, BinaryData encryption_key);
 
+    struct WriteCopyOptions {
+        // The maximum rate to write the copy at, or zero for no limit
+        uint64_t max_bytes_per_second = 0;
+        // Called on the background thread after each chunk is written with the
+        // number of bytes written so far and an estimate of the total size
+        std::function<void (uint64_t written_bytes, uint64_t total_bytes)> progress;
+        // Polled on the background thread before each chunk is written and
+        // while waiting for the rate limit. If it returns true the copy is
+        // abandoned and the partial file is removed.
+        std::function<bool ()> should_cancel;
+    };
+    // Write a copy of the Realm as of the current read transaction version to
+    // `path` on a background thread, leaving this Realm free to advance or
+    // write while the copy is made. `completion` is called on the background
+    // thread with the error which occurred, if any (including
+    // WriteCopyCancelledException if it was cancelled), and must not throw.
+    // Closing the last Realm instance for this file cancels any copies which
+    // are still being written in the same way as `should_cancel`.
+    // The rate limit, progress and cancellation are not supported when an
+    // encryption key is given, as the copy is then written by core in one
+    // step, so closing the last Realm instance waits for such a copy.
+    void write_copy_async(std::string path, BinaryData encryption_key, WriteCopyOptions options,
+                          std::function<void (std::exception_ptr)> completion);
+
     std::thread::id thread_id() const { return m_thread_id; }
     void verify_thread() const;
     void verify_in_write() const;
@@ -213,6 +320,37 @@ public:
     // importing each object for handover.
     std::vector<AnyThreadConfined> accept_handover(Realm::HandoverPackage handover);
 
+    // Pins the current version and returns a package of the objects at that
+    // version which can be read from any number of threads at once.
+    FrozenPackage freeze(std::vector<AnyThreadConfined> objects_to_freeze);
+
+    // Immutable set of objects frozen at a single version of the Realm. Unlike
+    // a HandoverPackage it can be copied and resolved any number of times on
+    // any thread, and the version remains pinned until the last copy is
+    // destroyed.
+    class FrozenPackage {
+    public:
+        FrozenPackage() = default;
+
+        // Get the frozen objects for use on the calling thread. Core
+        // accessors can't be shared between threads, so each thread reads
+        // from its own frozen Realm at the pinned version, which is reused by
+        // later calls on that thread for as long as it is alive.
+        std::vector<AnyThreadConfined> resolve() const;
+        // Get the calling thread's frozen Realm without resolving any of
+        // the objects, for reading other data at the pinned version
+        SharedRealm resolve_realm() const;
+
+        bool is_valid() const noexcept { return !!m_state; }
+        size_t size() const noexcept;
+
+    private:
+        friend FrozenPackage Realm::freeze(std::vector<AnyThreadConfined> objects_to_freeze);
+
+        struct State;
+        std::shared_ptr<State> m_state;
+    };
+
     // Opaque type representing a vector of packaged objects for handover
     class HandoverPackage {
     public:
@@ -274,6 +412,7 @@ public:
         friend class _impl::RealmCoordinator;
         friend class _impl::ResultsNotifier;
         friend class _impl::AnyHandover;
+        friend class _impl::RowPositionIndex;
 
         // ResultsNotifier and ListNotifier need access to the SharedGroup
         // to be able to call the handover functions, which are not very wrappable
@@ -297,7 +436,11 @@ private:
 
     Config m_config;
     std::thread::id m_thread_id = std::this_thread::get_id();
+    // Internal Realms which are only used with a lock held, such as the source
+    // Realm of a FrozenPackage, can be used from any thread
+    bool m_thread_confined = true;
     bool m_auto_refresh = true;
+    bool m_frozen = false;
 
     std::unique_ptr<Replication> m_history;
     std::unique_ptr<SharedGroup> m_shared_group;
@@ -308,13 +451,27 @@ private:
     uint64_t m_schema_version;
     Schema m_schema;
     uint64_t m_schema_transaction_version = -1;
+    // Set when m_schema has not been read from the file yet. Until it is,
+    // find_object_schema() reads classes individually into
+    // m_partial_object_schemas, which are kept for the Realm's lifetime as
+    // callers hold on to the pointers to them.
+    bool m_schema_is_partial = false;
+    std::unordered_map<std::string, std::unique_ptr<ObjectSchema>> m_partial_object_schemas;
 
     std::shared_ptr<_impl::RealmCoordinator> m_coordinator;
 
+    // Completion handlers for async_write() which are ready to be called on
+    // this Realm's thread, filled in from the thread performing the write
+    struct AsyncWriteCompletions;
+    std::shared_ptr<AsyncWriteCompletions> m_async_write_completions;
+
     // File format versions populated when a file format upgrade takes place during realm opening
     int upgrade_initial_version = 0, upgrade_final_version = 0;
 
     void set_schema(Schema schema, uint64_t version);
+    // Set the schema without comparing it to the file's schema if the file's
+    // stored fingerprint says that it matches, and return whether it did
+    bool set_schema_from_fingerprint(Schema& schema, uint64_t version, uint64_t fingerprint);
     void reset_file_if_needed(Schema const& schema, uint64_t version, std::vector<SchemaChange>& changes_required);
 
     // Ensure that m_schema and m_schema_version match that of the current
@@ -381,6 +538,11 @@ public:
     UninitializedRealmException(std::string message) : std::runtime_error(message) {}
 };
 
+class WriteCopyCancelledException : public std::runtime_error {
+public:
+    WriteCopyCancelledException() : std::runtime_error("Writing a copy of the Realm was cancelled.") {}
+};
+
 class InvalidEncryptionKeyException : public std::logic_error {
 public:
     InvalidEncryptionKeyException() : std::logic_error("Encryption key must be 64 bytes.") {}
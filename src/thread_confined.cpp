@@ -108,9 +108,12 @@ _impl::AnyHandover AnyThreadConfined::export_for_handover() const
 {
     SharedGroup& shared_group = Realm::Internal::get_shared_group(*get_realm());
     switch (m_type) {
-        case AnyThreadConfined::Type::Object:
-            return _impl::AnyHandover(shared_group.export_for_handover(m_object.row()),
-                                      m_object.get_object_schema().name);
+        case AnyThreadConfined::Type::Object: {
+            Row row = m_object.row();
+            if (!row.is_attached())
+                return _impl::AnyHandover(npos, npos, m_object.get_object_schema().name);
+            return _impl::AnyHandover(row.get_table()->get_index_in_group(), row.get_index(), "");
+        }
 
         case AnyThreadConfined::Type::List:
             return _impl::AnyHandover(shared_group.export_linkview_for_handover(m_list.m_link_view));
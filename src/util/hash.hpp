@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef REALM_UTIL_HASH_HPP
+#define REALM_UTIL_HASH_HPP
+
+#include <realm/string_data.hpp>
+
+#include <cstdint>
+
+namespace realm {
+namespace util {
+constexpr uint64_t fnv1a_offset_basis = 14695981039346656037ULL;
+
+// 64-bit FNV-1a. Unlike std::hash this is stable across platforms and
+// processes, so it can be used for values which are persisted in the file.
+// Pass the result of a previous call as `hash` to hash several values.
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash=fnv1a_offset_basis)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a(StringData value, uint64_t hash=fnv1a_offset_basis)
+{
+    return fnv1a(value.data(), value.size(), hash);
+}
+
+// Functor for using StringData as the key in unordered containers
+struct StringDataHash {
+    size_t operator()(StringData value) const noexcept { return static_cast<size_t>(fnv1a(value)); }
+};
+} // namespace util
+} // namespace realm
+
+#endif // REALM_UTIL_HASH_HPP
@@ -58,6 +58,15 @@ TEST_CASE("collection_change: insert()") {
         c.insert(4);
         REQUIRE_MOVES(c, {10, 6}, {10, 2}, {3, 11});
     }
+
+    SECTION("merges repeated appends into a single range") {
+        c.modify(2);
+        for (size_t i = 10; i < 1000; ++i)
+            c.insert(i);
+        REQUIRE(c.insertions.count() == 990);
+        REQUIRE(std::distance(c.insertions.begin(), c.insertions.end()) == 1);
+        REQUIRE_INDICES(c.modifications, 2);
+    }
 }
 
 TEST_CASE("collection_change: modify()") {
@@ -81,6 +90,49 @@ TEST_CASE("collection_change: modify()") {
         c.modify(5);
         REQUIRE_INDICES(c.modifications, 5);
     }
+
+    SECTION("records the modified column if one is given") {
+        c.modify(5, 1);
+        c.modify(6, 2);
+        c.modify(7);
+        REQUIRE_INDICES(c.modifications, 5, 6, 7);
+        REQUIRE(c.columns.size() == 2);
+        REQUIRE_INDICES(c.columns[1], 5);
+        REQUIRE_INDICES(c.columns[2], 6);
+    }
+
+    SECTION("column modifications are shifted along with row modifications") {
+        c.modify(5, 1);
+        c.modify(8, 2);
+        c.insert(0);
+        c.erase(7);
+        REQUIRE_INDICES(c.columns[1], 6);
+        REQUIRE(c.columns[2].empty());
+
+        c.move_over(0, 6);
+        REQUIRE_INDICES(c.columns[1], 0);
+    }
+
+    SECTION("column modifications are reported for the old collection after finalize") {
+        c.insert(0);
+        c.modify(3, 1);
+        c.modify(0, 2);
+        auto changes = std::move(c).finalize();
+        REQUIRE_INDICES(changes.modifications, 2);
+        REQUIRE(changes.columns.size() == 1);
+        REQUIRE_INDICES(changes.columns[1], 2);
+    }
+
+    SECTION("column modifications are merged") {
+        c.modify(1, 1);
+        _impl::CollectionChangeBuilder c2;
+        c2.insert(0);
+        c2.modify(3, 1);
+        c2.modify(4, 2);
+        c.merge(std::move(c2));
+        REQUIRE_INDICES(c.columns[1], 2, 3);
+        REQUIRE_INDICES(c.columns[2], 4);
+    }
 }
 
 TEST_CASE("collection_change: erase()") {
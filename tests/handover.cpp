@@ -299,6 +299,23 @@ TEST_CASE("handover") {
             REQUIRE(num.row().get_int(0) == 42);
         }
 
+        SECTION("deleted object") {
+            r->begin_transaction();
+            Object num = create_object(r, int_object);
+            num.row().move_last_over();
+            r->commit_transaction();
+
+            REQUIRE(!num.is_valid());
+            auto h = r->package_for_handover({{num}});
+            std::thread([h = std::move(h), config]() mutable {
+                SharedRealm r = Realm::get_shared_realm(config);
+                auto h_import = r->accept_handover(std::move(h));
+                Object num = h_import[0].get_object();
+                REQUIRE(!num.is_valid());
+                REQUIRE(num.get_object_schema().name == "int_object");
+            }).join();
+        }
+
         SECTION("array") {
             r->begin_transaction();
             Object zero = create_object(r, int_object);
@@ -459,4 +476,96 @@ TEST_CASE("handover") {
         r->accept_handover(std::move(h));
         REQUIRE_THROWS(r->accept_handover(std::move(h)));
     }
+
+    SECTION("freeze") {
+        auto results = Results(r, get_table(*r, int_object)->where().greater(0, 0));
+
+        r->begin_transaction();
+        Object num = create_object(r, int_object);
+        num.row().set_int(0, 5);
+        List lst = get_list(create_object(r, int_array_object), 0);
+        lst.add(num.row().get_index());
+        r->commit_transaction();
+
+        auto frozen = r->freeze({{num}, {lst}, {results}});
+        REQUIRE(frozen.size() == 3);
+
+        r->begin_transaction();
+        num.row().set_int(0, 6);
+        lst.remove_all();
+        create_object(r, int_object).row().set_int(0, 7);
+        r->commit_transaction();
+
+        auto verify = [](std::vector<AnyThreadConfined> objects) {
+            REQUIRE(objects[0].get_realm()->is_frozen());
+            REQUIRE(objects[0].get_object().row().get_int(0) == 5);
+            REQUIRE(objects[1].get_list().size() == 1);
+            REQUIRE(objects[1].get_list().get(0).get_int(0) == 5);
+            REQUIRE(objects[2].get_results().size() == 1);
+        };
+
+        SECTION("is readable after the source Realm advances") {
+            verify(frozen.resolve());
+            REQUIRE(num.row().get_int(0) == 6);
+            REQUIRE(lst.size() == 0);
+            REQUIRE(results.size() == 2);
+        }
+
+        SECTION("can be resolved on several threads at once") {
+            std::vector<std::thread> threads;
+            for (int i = 0; i < 4; ++i) {
+                threads.emplace_back([=] {
+                    verify(frozen.resolve());
+                    verify(frozen.resolve());
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+        SECTION("reuses the frozen Realm on each thread") {
+            auto first = frozen.resolve();
+            auto second = frozen.resolve();
+            REQUIRE(first[0].get_realm() == second[0].get_realm());
+        }
+
+        SECTION("keeps the version pinned after the source Realm moves on") {
+            r->invalidate();
+            r->begin_transaction();
+            r->commit_transaction();
+            verify(frozen.resolve());
+        }
+
+        SECTION("disallows writes and notifications") {
+            auto objects = frozen.resolve();
+            auto frozen_realm = objects[0].get_realm();
+            REQUIRE_THROWS(frozen_realm->begin_transaction());
+            REQUIRE_THROWS(frozen_realm->refresh());
+            REQUIRE_THROWS(objects[1].get_list().add_notification_callback([](CollectionChangeSet, std::exception_ptr) {}));
+            REQUIRE_THROWS(objects[2].get_results().add_notification_callback([](CollectionChangeSet, std::exception_ptr) {}));
+            REQUIRE_FALSE(frozen_realm->can_deliver_notifications());
+        }
+
+        SECTION("disallows schema changes") {
+            auto frozen_realm = frozen.resolve()[0].get_realm();
+            REQUIRE_THROWS_AS(frozen_realm->update_schema(frozen_realm->schema(), frozen_realm->schema_version()),
+                              InvalidTransactionException);
+            REQUIRE_NOTHROW(frozen_realm->flush());
+        }
+
+        SECTION("confines the objects resolved on each thread to that thread") {
+            std::vector<AnyThreadConfined> other_thread_objects;
+            std::thread([&] {
+                other_thread_objects = frozen.resolve();
+            }).join();
+            REQUIRE_THROWS_AS(other_thread_objects[1].get_list().size(), IncorrectThreadException);
+            verify(frozen.resolve());
+        }
+
+        SECTION("is disallowed during write transactions") {
+            r->begin_transaction();
+            REQUIRE_THROWS(r->freeze({}));
+            r->cancel_transaction();
+        }
+    }
 }
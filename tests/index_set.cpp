@@ -22,6 +22,8 @@
 
 #include "util/index_helpers.hpp"
 
+#include <algorithm>
+
 TEST_CASE("index_set: contains()") {
     SECTION("returns false if the index is before the first entry in the set") {
         realm::IndexSet set = {1, 2, 5};
@@ -151,6 +153,48 @@ TEST_CASE("index_set: add()") {
     }
 }
 
+TEST_CASE("index_set: append()") {
+    realm::IndexSet set;
+
+    SECTION("adds a range to an empty set") {
+        set.append(3, 2);
+        REQUIRE_INDICES(set, 3, 4);
+    }
+
+    SECTION("extends the last range when adjacent to it") {
+        set = {0, 1, 5};
+        set.append(6);
+        set.append(7, 2);
+        REQUIRE_INDICES(set, 0, 1, 5, 6, 7, 8);
+    }
+
+    SECTION("does not extend ranges over gaps") {
+        set = {0, 1};
+        set.append(3);
+        REQUIRE_INDICES(set, 0, 1, 3);
+    }
+
+    SECTION("produces the same result as add() across chunks") {
+        realm::IndexSet set2;
+        for (size_t i = 0; i < 40; ++i) {
+            set.append(i * 3, 2);
+            set2.add(i * 3);
+            set2.add(i * 3 + 1);
+        }
+        REQUIRE(set.count() == set2.count());
+        REQUIRE(std::equal(set.begin(), set.end(), set2.begin(), set2.end()));
+    }
+}
+
+TEST_CASE("index_set: ends_before()") {
+    realm::IndexSet set;
+    REQUIRE(set.ends_before(0));
+    set = {1, 2, 5};
+    REQUIRE(set.ends_before(6));
+    REQUIRE_FALSE(set.ends_before(5));
+    REQUIRE_FALSE(set.ends_before(0));
+}
+
 TEST_CASE("index_set: add_shifted()") {
     realm::IndexSet set;
 
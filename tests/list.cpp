@@ -123,6 +123,40 @@ TEST_CASE("list") {
             REQUIRE_INDICES(change.deletions, 5);
         }
 
+        SECTION("assigning nearly identical contents reports only the differences") {
+            auto token = require_change();
+            write([&] { lst.assign({0, 1, 2, 3, 4, 6, 7, 8, 8, 9, 5}); });
+            REQUIRE_INDICES(change.deletions, 5);
+            REQUIRE_INDICES(change.insertions, 8, 10);
+            REQUIRE(change.modifications.empty());
+        }
+
+        SECTION("appending to the list reports just the new rows") {
+            auto token = require_change();
+            write([&] {
+                for (size_t i = 0; i < 10; ++i)
+                    lst.add(i);
+            });
+            REQUIRE_INDICES(change.insertions, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19);
+            REQUIRE(change.modifications.empty());
+            REQUIRE(change.deletions.empty());
+        }
+
+        SECTION("appending to the list and modifying a linked row reports both") {
+            auto token = require_change();
+            write([&] {
+                lst.add(3);
+                target->set_int(0, 3, 30);
+            });
+            REQUIRE_INDICES(change.insertions, 10);
+            REQUIRE(change.modifications.contains(3));
+        }
+
+        SECTION("assigning identical contents sends no change notification") {
+            auto token = require_no_change();
+            write([&] { lst.assign({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}); });
+        }
+
         SECTION("modifying a different list doesn't send a change notification") {
             auto token = require_no_change();
             write([&] { lv2->remove(5); });
@@ -577,6 +611,100 @@ TEST_CASE("list") {
         REQUIRE(snapshot.size() == 10);
     }
 
+    SECTION("assign()") {
+        List list(r, lv);
+        auto require_contents = [&](std::vector<size_t> expected) {
+            REQUIRE(list.size() == expected.size());
+            for (size_t i = 0; i < expected.size(); ++i)
+                REQUIRE(list.get_unchecked(i) == expected[i]);
+        };
+
+        r->begin_transaction();
+        SECTION("replaces all of the contents") {
+            list.assign({9, 3, 3, 0});
+            require_contents({9, 3, 3, 0});
+        }
+        SECTION("can empty the list") {
+            list.assign({});
+            require_contents({});
+        }
+        SECTION("can fill an empty list") {
+            list.remove_all();
+            list.assign({1, 2});
+            require_contents({1, 2});
+        }
+        SECTION("handles reordering") {
+            list.assign({9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
+            require_contents({9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
+        }
+        r->cancel_transaction();
+    }
+
+    SECTION("splice()") {
+        List list(r, lv);
+        r->begin_transaction();
+        SECTION("replaces the given range") {
+            list.splice(2, 3, {7, 7});
+            std::vector<size_t> expected{0, 1, 7, 7, 5, 6, 7, 8, 9};
+            REQUIRE(list.size() == expected.size());
+            for (size_t i = 0; i < expected.size(); ++i)
+                REQUIRE(list.get_unchecked(i) == expected[i]);
+        }
+        SECTION("can insert at the end") {
+            list.splice(10, 0, {3});
+            REQUIRE(list.size() == 11);
+            REQUIRE(list.get_unchecked(10) == 3);
+        }
+        SECTION("rejects out of bounds ranges") {
+            REQUIRE_THROWS(list.splice(11, 0, {}));
+            REQUIRE_THROWS(list.splice(8, 3, {}));
+        }
+        r->cancel_transaction();
+    }
+
+    SECTION("find()") {
+        List list(r, lv);
+        r->begin_transaction();
+        for (int i = 0; i < 20; ++i)
+            lv->add(i % 10);
+        r->commit_transaction();
+
+        // Repeated lookups at the same version go through the cached index
+        for (int pass = 0; pass < 2; ++pass) {
+            REQUIRE(list.find(target->get(0)) == 0);
+            REQUIRE(list.find(target->get(9)) == 9);
+        }
+
+        SECTION("sees changes made by committed writes") {
+            r->begin_transaction();
+            list.remove(0);
+            list.move(3, 0);
+            r->commit_transaction();
+            REQUIRE(list.find(target->get(4)) == 0);
+            REQUIRE(list.find(target->get(0)) == 9);
+            REQUIRE(list.find(target->get(1)) == 1);
+        }
+
+        SECTION("sees changes made within a write transaction") {
+            r->begin_transaction();
+            list.remove(0);
+            REQUIRE(list.find(target->get(0)) == 9);
+            list.insert(0, 0);
+            REQUIRE(list.find(target->get(0)) == 0);
+            r->cancel_transaction();
+            REQUIRE(list.find(target->get(0)) == 0);
+            REQUIRE(list.find(target->get(9)) == 9);
+        }
+
+        SECTION("returns not_found for rows not in the list") {
+            r->begin_transaction();
+            size_t row = target->add_empty_row();
+            r->commit_transaction();
+            REQUIRE(list.find(target->get(row)) == not_found);
+            REQUIRE(list.find(target->get(row)) == not_found);
+        }
+    }
+
     SECTION("get_object_schema()") {
         List list(r, lv);
         auto objectschema = &*r->schema().find("target");
@@ -25,6 +25,8 @@
 #include "property.hpp"
 #include "schema.hpp"
 
+#include "util/format.hpp"
+
 #include <realm/descriptor.hpp>
 #include <realm/group.hpp>
 #include <realm/table.hpp>
@@ -313,6 +315,155 @@ TEST_CASE("migration: Automatic") {
         }
     }
 
+    SECTION("schema fingerprint") {
+        Schema schema = {
+            {"object", {
+                {"value", PropertyType::Int, "", "", false, false, false},
+            }},
+        };
+
+        SECTION("is stored when the schema is applied") {
+            auto realm = Realm::get_shared_realm(config);
+            REQUIRE_UPDATE_SUCCEEDS(*realm, schema, 1);
+            REQUIRE(ObjectStore::get_schema_fingerprint(realm->read_group()) == schema.fingerprint());
+
+            schema = set_optional(schema, "object", "value", true);
+            REQUIRE_UPDATE_SUCCEEDS(*realm, schema, 2);
+            REQUIRE(ObjectStore::get_schema_fingerprint(realm->read_group()) == schema.fingerprint());
+        }
+
+        SECTION("is used to open with an unchanged schema") {
+            config.cache = false;
+            auto realm = Realm::get_shared_realm(config);
+            REQUIRE_UPDATE_SUCCEEDS(*realm, schema, 1);
+
+            auto realm2 = Realm::get_shared_realm(config);
+            REQUIRE_NOTHROW(realm2->update_schema(schema, 1));
+            REQUIRE(realm2->schema() == schema);
+            REQUIRE(realm2->schema().find("object")->persisted_properties[0].table_column == 0);
+        }
+
+        SECTION("is not trusted if the tables were changed without clearing it") {
+            config.cache = false;
+            auto realm = Realm::get_shared_realm(config);
+            REQUIRE_UPDATE_SUCCEEDS(*realm, schema, 1);
+            auto modify_table = [&](auto&& fn) {
+                realm->begin_transaction();
+                fn(*ObjectStore::table_for_object_type(realm->read_group(), "object"));
+                realm->commit_transaction();
+                REQUIRE(ObjectStore::get_schema_fingerprint(realm->read_group()) == schema.fingerprint());
+            };
+
+            SECTION("extra column") {
+                modify_table([](Table& table) { table.add_column(type_Int, "extra"); });
+            }
+            SECTION("column type") {
+                modify_table([](Table& table) {
+                    table.remove_column(table.get_column_index("value"));
+                    table.add_column(type_String, "value");
+                });
+            }
+            SECTION("column nullability") {
+                modify_table([](Table& table) {
+                    table.remove_column(table.get_column_index("value"));
+                    table.add_column(type_Int, "value", true);
+                });
+            }
+            SECTION("link target") {
+                schema = Schema{
+                    {"object", {
+                        {"link", PropertyType::Object, "target", "", false, false, true},
+                    }},
+                    {"target", {
+                        {"value", PropertyType::Int, "", "", false, false, false},
+                    }},
+                    {"other target", {
+                        {"value", PropertyType::Int, "", "", false, false, false},
+                    }},
+                };
+                REQUIRE_UPDATE_SUCCEEDS(*realm, schema, 2);
+                modify_table([&](Table& table) {
+                    table.remove_column(table.get_column_index("link"));
+                    table.add_column_link(type_Link, "link",
+                                          *ObjectStore::table_for_object_type(realm->read_group(), "other target"));
+                });
+            }
+
+            auto realm2 = Realm::get_shared_realm(config);
+            REQUIRE_THROWS(realm2->update_schema(schema, realm->schema_version()));
+        }
+
+        SECTION("is not stored just by opening a file which matches the schema but has none") {
+            config.cache = false;
+            auto realm = Realm::get_shared_realm(config);
+            REQUIRE_UPDATE_SUCCEEDS(*realm, schema, 1);
+            realm->begin_transaction();
+            ObjectStore::store_schema_fingerprint(realm->read_group(), 0);
+            realm->commit_transaction();
+
+            auto realm2 = Realm::get_shared_realm(config);
+            REQUIRE_UPDATE_SUCCEEDS(*realm2, schema, 1);
+            REQUIRE(ObjectStore::get_schema_fingerprint(realm2->read_group()) == 0);
+
+            // But it is once the file is next written by update_schema()
+            REQUIRE_UPDATE_SUCCEEDS(*realm2, schema, 2);
+            REQUIRE(ObjectStore::get_schema_fingerprint(realm2->read_group()) == schema.fingerprint());
+        }
+
+        SECTION("is cleared when tables are modified through the ObjectStore") {
+            auto realm = Realm::get_shared_realm(config);
+            REQUIRE_UPDATE_SUCCEEDS(*realm, schema, 1);
+            realm->begin_transaction();
+            ObjectStore::set_primary_key_for_object(realm->read_group(), "object", "value");
+            realm->commit_transaction();
+            REQUIRE(ObjectStore::get_schema_fingerprint(realm->read_group()) == 0);
+        }
+    }
+
+    SECTION("primary key validation") {
+        Schema schema = {
+            {"object", {
+                {"value", PropertyType::Int, "", "", true, false, false},
+            }},
+            {"object 2", {
+                {"value", PropertyType::Int, "", "", false, false, false},
+            }},
+        };
+        std::vector<std::pair<size_t, size_t>> progress;
+        config.primary_key_validation_progress_function = [&](size_t validated, size_t total) {
+            progress.emplace_back(validated, total);
+        };
+        auto realm = Realm::get_shared_realm(config);
+        realm->update_schema(schema, 1);
+        realm->begin_transaction();
+        auto table = ObjectStore::table_for_object_type(realm->read_group(), "object 2");
+        table->add_empty_row(3);
+        for (size_t i = 0; i < 3; ++i)
+            table->set_int(0, i, i);
+        realm->commit_transaction();
+        progress.clear();
+
+        SECTION("checks each table once when a migration function is used") {
+            realm->update_schema(set_primary_key(schema, "object 2", "value"), 2,
+                                 [](SharedRealm, SharedRealm, Schema&) { });
+            REQUIRE(progress == (std::vector<std::pair<size_t, size_t>>{{1, 2}, {2, 2}}));
+        }
+
+        SECTION("checks only new primary keys without a migration function") {
+            realm->update_schema(set_primary_key(schema, "object 2", "value"), 2);
+            REQUIRE(progress == (std::vector<std::pair<size_t, size_t>>{{1, 1}}));
+        }
+
+        SECTION("reports duplicates after adding a primary key") {
+            realm->begin_transaction();
+            table->set_int(0, 2, 0);
+            realm->commit_transaction();
+            REQUIRE_THROWS_AS(realm->update_schema(set_primary_key(schema, "object 2", "value"), 2,
+                                                   [](SharedRealm, SharedRealm, Schema&) { }),
+                              DuplicatePrimaryKeyValueException);
+        }
+    }
+
     SECTION("migration block invocations") {
         SECTION("not called for initial creation of schema") {
             Schema schema = {
@@ -374,6 +525,39 @@ TEST_CASE("migration: Automatic") {
             }));
         }
 
+        SECTION("insert duplicate string keys for existing PK during migration") {
+            Schema schema = {
+                {"object", {
+                    {"value", PropertyType::String, "", "", true, false, false},
+                }},
+            };
+            auto realm = Realm::get_shared_realm(config);
+            realm->update_schema(schema, 1);
+            REQUIRE_THROWS_AS(realm->update_schema(schema, 2, [](SharedRealm, SharedRealm realm, Schema&) {
+                auto table = ObjectStore::table_for_object_type(realm->read_group(), "object");
+                table->add_empty_row(100);
+                for (size_t i = 0; i < 100; ++i)
+                    table->set_string(0, i, util::format("%1", i));
+                table->set_string(0, 50, "10");
+            }), DuplicatePrimaryKeyValueException);
+        }
+
+        SECTION("unique string keys for existing PK during migration") {
+            Schema schema = {
+                {"object", {
+                    {"value", PropertyType::String, "", "", true, false, false},
+                }},
+            };
+            auto realm = Realm::get_shared_realm(config);
+            realm->update_schema(schema, 1);
+            REQUIRE_NOTHROW(realm->update_schema(schema, 2, [](SharedRealm, SharedRealm realm, Schema&) {
+                auto table = ObjectStore::table_for_object_type(realm->read_group(), "object");
+                table->add_empty_row(100);
+                for (size_t i = 0; i < 100; ++i)
+                    table->set_string(0, i, util::format("%1", i));
+            }));
+        }
+
         SECTION("add pk to existing table with duplicate keys") {
             Schema schema = {
                 {"object", {
@@ -455,6 +639,42 @@ TEST_CASE("migration: Automatic") {
                 REQUIRE(table->get_int(0, i) == i);
         }
 
+        SECTION("values for multiple required properties are copied when converting to nullable") {
+            Schema schema = {
+                {"object", {
+                    {"int", PropertyType::Int, "", "", false, false, false},
+                    {"string", PropertyType::String, "", "", false, true, false},
+                    {"unchanged", PropertyType::Int, "", "", false, false, false},
+                    {"double", PropertyType::Double, "", "", false, false, false},
+                }},
+            };
+            auto realm = Realm::get_shared_realm(config);
+            realm->update_schema(schema, 1);
+
+            realm->begin_transaction();
+            auto table = ObjectStore::table_for_object_type(realm->read_group(), "object");
+            table->add_empty_row(2500);
+            for (size_t i = 0; i < 2500; ++i) {
+                table->set_int(0, i, i);
+                table->set_string(1, i, util::format("%1", i));
+                table->set_int(2, i, i * 2);
+                table->set_double(3, i, i / 2.0);
+            }
+            realm->commit_transaction();
+
+            schema = set_optional(schema, "object", "int", true);
+            schema = set_optional(schema, "object", "string", true);
+            schema = set_optional(schema, "object", "double", true);
+            REQUIRE_UPDATE_SUCCEEDS(*realm, schema, 2);
+            REQUIRE(table->size() == 2500);
+            for (size_t i = 0; i < 2500; ++i) {
+                REQUIRE(table->get_int(0, i) == i);
+                REQUIRE(table->get_string(1, i) == util::format("%1", i));
+                REQUIRE(table->get_int(2, i) == i * 2);
+                REQUIRE(table->get_double(3, i) == i / 2.0);
+            }
+        }
+
         SECTION("values for nullable properties are discarded when converitng to required") {
             Schema schema = {
                 {"object", {
@@ -952,6 +1172,20 @@ TEST_CASE("migration: Additive") {
     };
     realm->update_schema(schema);
 
+    SECTION("stores the schema fingerprint once the file matches the schema") {
+        auto schema2 = add_property(schema, "object", {"value 3", PropertyType::Int, "", "", false, false, false});
+        realm->update_schema(schema2);
+        REQUIRE(ObjectStore::get_schema_fingerprint(realm->read_group()) == 0);
+
+        // Opening doesn't write to the file just to store it
+        auto realm2 = Realm::get_shared_realm(config);
+        realm2->update_schema(schema2);
+        REQUIRE(ObjectStore::get_schema_fingerprint(realm2->read_group()) == 0);
+
+        realm2->update_schema(schema2, 1);
+        REQUIRE(ObjectStore::get_schema_fingerprint(realm2->read_group()) == schema2.fingerprint());
+    }
+
     SECTION("can add new properties to existing tables") {
         REQUIRE_NOTHROW(realm->update_schema(add_property(schema, "object",
                                                           {"value 3", PropertyType::Int, "", "", false, false, false})));
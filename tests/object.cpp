@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+#include "util/index_helpers.hpp"
+
+#include "object_accessor.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+
+#include "impl/realm_coordinator.hpp"
+
+#include <realm/group_shared.hpp>
+#include <realm/link_view.hpp>
+
+using namespace realm;
+
+TEST_CASE("object: notifications") {
+    InMemoryTestFile config;
+    config.automatic_change_notifications = false;
+    config.cache = false;
+    auto r = Realm::get_shared_realm(config);
+    r->update_schema({
+        {"table", {
+            {"value 1", PropertyType::Int},
+            {"value 2", PropertyType::Int},
+            {"link", PropertyType::Object, "target", "", false, false, true},
+            {"array", PropertyType::Array, "target"}
+        }},
+        {"target", {
+            {"value", PropertyType::Int}
+        }},
+    });
+
+    auto table = r->read_group().get_table("class_table");
+    auto target = r->read_group().get_table("class_target");
+
+    r->begin_transaction();
+    table->add_empty_row(10);
+    target->add_empty_row(2);
+    table->set_link(2, 0, 0);
+    table->get_linklist(3, 0)->add(1);
+    r->commit_transaction();
+
+    Object object(r, *r->schema().find("table"), table->get(0));
+
+    auto write = [&](auto&& f) {
+        r->begin_transaction();
+        f();
+        r->commit_transaction();
+        advance_and_notify(*r);
+    };
+
+    int calls = 0;
+    CollectionChangeSet change;
+    auto callback = [&](CollectionChangeSet c, std::exception_ptr err) {
+        REQUIRE_FALSE(err);
+        change = c;
+        ++calls;
+    };
+
+    SECTION("initial notification is delivered with no changes") {
+        auto token = object.add_notification_callback(callback);
+        advance_and_notify(*r);
+        REQUIRE(calls == 1);
+        REQUIRE(change.empty());
+    }
+
+    SECTION("modifying the object reports the modified properties") {
+        auto token = object.add_notification_callback(callback);
+        advance_and_notify(*r);
+
+        write([&] {
+            table->set_int(1, 0, 5);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.modifications, 0);
+        REQUIRE(change.columns.size() == 1);
+        REQUIRE_INDICES(change.columns[1], 0);
+    }
+
+    SECTION("modifying other objects does not send notifications") {
+        auto token = object.add_notification_callback(callback);
+        advance_and_notify(*r);
+
+        write([&] {
+            table->set_int(0, 1, 5);
+            target->add_empty_row();
+        });
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("modifying a linked object reports a change to the link property") {
+        auto token = object.add_notification_callback(callback);
+        advance_and_notify(*r);
+
+        write([&] {
+            target->set_int(0, 0, 5);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE(change.columns.size() == 1);
+        REQUIRE_INDICES(change.columns[2], 0);
+
+        write([&] {
+            target->set_int(0, 1, 5);
+        });
+        REQUIRE(calls == 3);
+        REQUIRE(change.columns.size() == 1);
+        REQUIRE_INDICES(change.columns[3], 0);
+    }
+
+    SECTION("the object is tracked when other rows are deleted") {
+        Object last(r, *r->schema().find("table"), table->get(9));
+        auto token = last.add_notification_callback(callback);
+        advance_and_notify(*r);
+
+        write([&] {
+            table->move_last_over(0);
+        });
+        REQUIRE(calls == 1);
+
+        write([&] {
+            table->set_int(0, 0, 5);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.columns[0], 0);
+    }
+
+    SECTION("deleting the object reports a deletion once") {
+        auto token = object.add_notification_callback(callback);
+        advance_and_notify(*r);
+
+        write([&] {
+            table->move_last_over(0);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.deletions, 0);
+        REQUIRE(change.modifications.empty());
+
+        write([&] {
+            table->set_int(0, 0, 5);
+        });
+        REQUIRE(calls == 2);
+    }
+
+    SECTION("key path filtered callbacks are only notified of changes to those properties") {
+        auto token = object.add_notification_callback(callback, {"value 2"});
+        advance_and_notify(*r);
+
+        write([&] {
+            table->set_int(0, 0, 5);
+            target->set_int(0, 0, 5);
+        });
+        REQUIRE(calls == 1);
+
+        write([&] {
+            table->set_int(1, 0, 5);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.columns[1], 0);
+    }
+
+    SECTION("adding a callback to a deleted object throws") {
+        r->begin_transaction();
+        table->move_last_over(0);
+        r->commit_transaction();
+        REQUIRE_THROWS(object.add_notification_callback(callback));
+    }
+}
@@ -21,14 +21,24 @@
 #include "util/test_file.hpp"
 
 #include "binding_context.hpp"
+#include "collection_notifications.hpp"
+#include "impl/collection_notifier.hpp"
+#include "impl/realm_coordinator.hpp"
 #include "object_schema.hpp"
 #include "object_store.hpp"
 #include "property.hpp"
+#include "results.hpp"
 #include "schema.hpp"
 
 #include <realm/group.hpp>
 #include <realm/util/file.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 using namespace realm;
 
 TEST_CASE("SharedRealm: get_shared_realm()") {
@@ -74,6 +84,9 @@ TEST_CASE("SharedRealm: get_shared_realm()") {
             auto realm = Realm::get_shared_realm(config);
             config.in_memory = true;
             REQUIRE_THROWS(Realm::get_shared_realm(config));
+            config.in_memory = false;
+            config.durability = Realm::Config::Durability::Deferred;
+            REQUIRE_THROWS(Realm::get_shared_realm(config));
         }
 
         SECTION("schema") {
@@ -153,6 +166,57 @@ TEST_CASE("SharedRealm: get_shared_realm()") {
         REQUIRE(it->persisted_properties[0].table_column == 0);
     }
 
+    SECTION("should read classes from the file as they're looked up if no schema is supplied") {
+        Realm::get_shared_realm(config);
+
+        config.schema = util::none;
+        config.cache = false;
+        for (auto mode : {SchemaMode::Automatic, SchemaMode::ReadOnly}) {
+            config.schema_mode = mode;
+            auto realm = Realm::get_shared_realm(config);
+            auto object_schema = realm->find_object_schema("object");
+            REQUIRE(object_schema);
+            REQUIRE(object_schema->persisted_properties.size() == 1);
+            REQUIRE(object_schema->persisted_properties[0].name == "value");
+            REQUIRE(object_schema->persisted_properties[0].table_column == 0);
+            REQUIRE(realm->find_object_schema("object") == object_schema);
+            REQUIRE_FALSE(realm->find_object_schema("missing"));
+
+            // Reading the full schema doesn't invalidate classes already read
+            REQUIRE(realm->schema().size() == 1);
+            REQUIRE(object_schema->name == "object");
+            REQUIRE(realm->find_object_schema("object") == &*realm->schema().find("object"));
+        }
+    }
+
+    SECTION("should populate the table columns in the schema when reopening with a schema") {
+        config.schema = Schema{
+            {"object", {
+                {"value", PropertyType::Int, "", "", false, false, false},
+                {"value2", PropertyType::Int, "", "", false, false, false}
+            }},
+        };
+        Realm::get_shared_realm(config);
+
+        auto realm = Realm::get_shared_realm(config);
+        REQUIRE(realm->schema() == *config.schema);
+        auto it = realm->schema().find("object");
+        REQUIRE(it->persisted_properties[0].table_column == 0);
+        REQUIRE(it->persisted_properties[1].table_column == 1);
+
+        realm->close();
+        config.schema = Schema{
+            {"object", {
+                {"value2", PropertyType::Int, "", "", false, false, false},
+                {"value", PropertyType::Int, "", "", false, false, false}
+            }},
+        };
+        realm = Realm::get_shared_realm(config);
+        it = realm->schema().find("object");
+        REQUIRE(it->persisted_properties[0].table_column == 1);
+        REQUIRE(it->persisted_properties[1].table_column == 0);
+    }
+
     SECTION("should populate the table columns in the schema when opening as read-only") {
         Realm::get_shared_realm(config);
 
@@ -172,6 +236,232 @@ TEST_CASE("SharedRealm: get_shared_realm()") {
     }
 }
 
+TEST_CASE("RealmCoordinator: get_coordinator()") {
+    TestFile config;
+
+    SECTION("returns the same coordinator for a path when called from many threads") {
+        std::vector<std::shared_ptr<_impl::RealmCoordinator>> coordinators(8);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < coordinators.size(); ++i) {
+            threads.emplace_back([&, i] {
+                coordinators[i] = _impl::RealmCoordinator::get_coordinator(config.path);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        for (auto& coordinator : coordinators)
+            REQUIRE(coordinator == coordinators[0]);
+        REQUIRE(_impl::RealmCoordinator::get_existing_coordinator(config.path) == coordinators[0]);
+    }
+
+    SECTION("returns distinct coordinators for distinct paths") {
+        TestFile config2;
+        auto coordinator = _impl::RealmCoordinator::get_coordinator(config.path);
+        auto coordinator2 = _impl::RealmCoordinator::get_coordinator(config2.path);
+        REQUIRE(coordinator != coordinator2);
+        REQUIRE(_impl::RealmCoordinator::get_existing_coordinator(config2.path) == coordinator2);
+    }
+
+    SECTION("does not keep coordinators alive") {
+        std::weak_ptr<_impl::RealmCoordinator> weak = _impl::RealmCoordinator::get_coordinator(config.path);
+        REQUIRE(weak.expired());
+        REQUIRE_FALSE(_impl::RealmCoordinator::get_existing_coordinator(config.path));
+        auto coordinator = _impl::RealmCoordinator::get_coordinator(config.path);
+        REQUIRE(coordinator);
+        REQUIRE(_impl::RealmCoordinator::get_existing_coordinator(config.path) == coordinator);
+    }
+
+    SECTION("clear_cache() forgets every coordinator") {
+        auto coordinator = _impl::RealmCoordinator::get_coordinator(config.path);
+        _impl::RealmCoordinator::clear_cache();
+        REQUIRE_FALSE(_impl::RealmCoordinator::get_existing_coordinator(config.path));
+        REQUIRE(_impl::RealmCoordinator::get_coordinator(config.path) != coordinator);
+    }
+}
+
+namespace {
+// A notifier which reports the changes to a table, and calls a hook at the
+// start of each run so that tests can control how long the run takes
+class TableNotifier : public _impl::CollectionNotifier {
+public:
+    TableNotifier(SharedRealm realm, Table const& table, std::function<void ()> on_run)
+    : CollectionNotifier(std::move(realm)), m_table_ndx(table.get_index_in_group()), m_on_run(std::move(on_run))
+    {
+        set_table(table);
+    }
+
+private:
+    size_t m_table_ndx;
+    std::function<void ()> m_on_run;
+    _impl::TransactionChangeInfo* m_info = nullptr;
+    _impl::CollectionChangeBuilder m_changes;
+
+    void release_data() noexcept override { }
+    void do_attach_to(SharedGroup&) override { }
+    void do_detach_from(SharedGroup&) override { }
+
+    bool do_add_required_change_info(_impl::TransactionChangeInfo& info) override
+    {
+        m_info = &info;
+        return true;
+    }
+
+    void run() override
+    {
+        m_on_run();
+        if (m_info && m_table_ndx < m_info->tables.size()) {
+            auto changes = m_info->tables[m_table_ndx];
+            m_changes.merge(std::move(changes));
+        }
+    }
+
+    void do_prepare_handover(SharedGroup&) override
+    {
+        add_changes(std::move(m_changes));
+        m_changes = {};
+    }
+};
+} // anonymous namespace
+
+TEST_CASE("RealmCoordinator: notifier scheduling") {
+    TestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.schema_version = 0;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int, "", "", false, false, false}
+        }},
+    };
+
+    auto realm = Realm::get_shared_realm(config);
+    auto& table = *realm->read_group().get_table("class_object");
+    auto coordinator = _impl::RealmCoordinator::get_existing_coordinator(config.path);
+
+    auto r2 = Realm::get_shared_realm(config);
+    auto add_row = [&] {
+        r2->begin_transaction();
+        r2->read_group().get_table("class_object")->add_empty_row();
+        r2->commit_transaction();
+    };
+
+    std::vector<std::shared_ptr<TableNotifier>> notifiers;
+    auto add_notifier = [&](std::function<void ()> on_run, std::function<void (CollectionChangeSet)> on_change = nullptr) {
+        auto notifier = std::make_shared<TableNotifier>(realm, table, std::move(on_run));
+        notifier->add_callback([=](CollectionChangeSet c, std::exception_ptr) {
+            if (on_change && !c.empty())
+                on_change(c);
+        });
+        _impl::RealmCoordinator::register_notifier(notifier);
+        notifiers.push_back(notifier);
+    };
+
+    std::vector<std::string> run_order;
+    auto record_run = [&](std::string name, std::chrono::milliseconds duration = {}) {
+        return [&, name, duration] {
+            run_order.push_back(name);
+            std::this_thread::sleep_for(duration);
+        };
+    };
+
+    SECTION("notifiers which took equally long run in the order they were added") {
+        add_notifier(record_run("first"));
+        add_notifier(record_run("second"));
+        add_notifier(record_run("third"));
+        advance_and_notify(*realm);
+        REQUIRE(run_order == (std::vector<std::string>{"first", "second", "third"}));
+    }
+
+    SECTION("notifiers which were quicker last time run first") {
+        add_notifier(record_run("slow", std::chrono::milliseconds(20)));
+        add_notifier(record_run("fast"));
+        advance_and_notify(*realm);
+        REQUIRE(run_order == (std::vector<std::string>{"slow", "fast"}));
+
+        run_order.clear();
+        add_row();
+        advance_and_notify(*realm);
+        REQUIRE(run_order == (std::vector<std::string>{"fast", "slow"}));
+    }
+
+    SECTION("a fast notifier is delivered while a slow one is still running") {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool block_slow = false;
+        bool slow_started = false;
+
+        std::vector<size_t> fast_insertions, slow_insertions;
+        add_notifier([&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!block_slow) {
+                // Make sure it's slower than the other one on the first run
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                return;
+            }
+            slow_started = true;
+            cv.notify_all();
+            cv.wait(lock, [&] { return !block_slow; });
+        }, [&](CollectionChangeSet c) { slow_insertions.push_back(c.insertions.count()); });
+        add_notifier([] { }, [&](CollectionChangeSet c) { fast_insertions.push_back(c.insertions.count()); });
+        advance_and_notify(*realm);
+
+        // Runs the worker until the slow notifier is blocked, at which point
+        // the fast one has already been run and handed over
+        auto start_worker = [&] {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                block_slow = true;
+                slow_started = false;
+            }
+            std::thread worker([&] { coordinator->on_change(); });
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return slow_started; });
+            return worker;
+        };
+        auto unblock = [&](std::thread& worker) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                block_slow = false;
+            }
+            cv.notify_all();
+            worker.join();
+        };
+
+        add_row();
+        auto worker = start_worker();
+        realm->notify();
+        REQUIRE(fast_insertions == std::vector<size_t>{1});
+        REQUIRE(slow_insertions.empty());
+        REQUIRE(table.size() == 1);
+
+        SECTION("and the slow one is delivered once it catches up") {
+            unblock(worker);
+            realm->notify();
+            REQUIRE(slow_insertions == std::vector<size_t>{1});
+        }
+
+        SECTION("and the slow one delivers the changes it accumulated while lagging behind") {
+            unblock(worker);
+            // The slow notifier is now ready at the Realm's version, but
+            // isn't delivered until the Realm is next notified, by which
+            // time the fast one is ready for a newer version
+            add_row();
+            worker = start_worker();
+            realm->notify();
+            REQUIRE(fast_insertions == (std::vector<size_t>{1, 1}));
+            REQUIRE(slow_insertions.empty());
+            REQUIRE(table.size() == 2);
+
+            unblock(worker);
+            realm->notify();
+            REQUIRE(slow_insertions == std::vector<size_t>{2});
+        }
+    }
+
+    for (auto& notifier : notifiers)
+        notifier->unregister();
+}
+
 TEST_CASE("SharedRealm: notifications") {
     if (!util::has_event_loop_implementation())
         return;
@@ -215,3 +505,490 @@ TEST_CASE("SharedRealm: notifications") {
         REQUIRE(change_count == 1);
     }
 }
+
+TEST_CASE("SharedRealm: notify() without notifiers") {
+    TestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.schema_version = 0;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int, "", "", false, false, false}
+        }},
+    };
+
+    auto realm = Realm::get_shared_realm(config);
+    auto table = realm->read_group().get_table("class_object");
+
+    // A second Realm with a notifier so that the notifier worker records the
+    // transaction logs it parses
+    auto r2 = Realm::get_shared_realm(config);
+    Results results(r2, *r2->read_group().get_table("class_object"));
+    auto token = results.add_notification_callback([](CollectionChangeSet, std::exception_ptr) { });
+    advance_and_notify(*r2);
+
+    auto add_row = [&] {
+        r2->begin_transaction();
+        r2->read_group().get_table("class_object")->add_empty_row();
+        r2->commit_transaction();
+    };
+
+    SECTION("advances to the version the notifier worker recorded") {
+        add_row();
+        _impl::RealmCoordinator::get_existing_coordinator(config.path)->on_change();
+        realm->notify();
+        REQUIRE(table->size() == 1);
+    }
+
+    SECTION("advances to the latest version when there have been commits since the worker ran") {
+        add_row();
+        _impl::RealmCoordinator::get_existing_coordinator(config.path)->on_change();
+        add_row();
+        realm->notify();
+        REQUIRE(table->size() == 2);
+    }
+}
+
+TEST_CASE("SharedRealm: enqueue_write()") {
+    TestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.schema_version = 0;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int, "", "", false, false, false}
+        }},
+    };
+
+    auto realm = Realm::get_shared_realm(config);
+    auto table = realm->read_group().get_table("class_object");
+    auto add_row = [](int64_t value) {
+        return [=](SharedRealm realm) {
+            auto table = realm->read_group().get_table("class_object");
+            table->set_int(0, table->add_empty_row(), value);
+        };
+    };
+
+    SECTION("performs the write and calls the completion on the calling thread when idle") {
+        bool called = false;
+        realm->enqueue_write(add_row(1), [&](std::exception_ptr error) {
+            REQUIRE_FALSE(error);
+            called = true;
+        });
+        REQUIRE(called);
+        REQUIRE(table->size() == 1);
+    }
+
+    SECTION("writes queued while writing are committed together") {
+        std::vector<int> completed;
+        realm->enqueue_write([&](SharedRealm r) {
+            add_row(1)(r);
+            // Queued behind the current batch
+            auto r2 = Realm::get_shared_realm(config);
+            r2->enqueue_write(add_row(2), [&](std::exception_ptr) { completed.push_back(2); });
+            r2->enqueue_write(add_row(3), [&](std::exception_ptr) { completed.push_back(3); });
+        }, [&](std::exception_ptr) { completed.push_back(1); });
+
+        REQUIRE(completed == (std::vector<int>{1, 2, 3}));
+        REQUIRE(table->size() == 3);
+    }
+
+    SECTION("a throwing write fails the writes in its transaction without running any of them again") {
+        std::exception_ptr first_error, second_error, third_error;
+        size_t first_runs = 0, third_runs = 0;
+        realm->enqueue_write([&](SharedRealm) {
+            Realm::get_shared_realm(config)->enqueue_write([&](SharedRealm r) { ++first_runs; add_row(1)(r); },
+                                                           [&](std::exception_ptr e) { first_error = e; });
+            Realm::get_shared_realm(config)->enqueue_write([](SharedRealm) { throw std::runtime_error("fail"); },
+                                                           [&](std::exception_ptr e) { second_error = e; });
+            Realm::get_shared_realm(config)->enqueue_write([&](SharedRealm r) { ++third_runs; add_row(2)(r); },
+                                                           [&](std::exception_ptr e) { third_error = e; });
+        });
+
+        REQUIRE(first_runs == 1);
+        REQUIRE(third_runs == 1);
+        REQUIRE_THROWS_WITH(std::rethrow_exception(first_error), "fail");
+        REQUIRE_THROWS_WITH(std::rethrow_exception(second_error), "fail");
+        REQUIRE_FALSE(third_error);
+        REQUIRE(table->size() == 1);
+        REQUIRE(table->get_int(0, 0) == 2);
+    }
+
+    SECTION("a throwing completion does not stop the rest of the queue") {
+        bool second_called = false;
+        REQUIRE_THROWS_WITH(realm->enqueue_write([&](SharedRealm r) {
+            add_row(1)(r);
+            Realm::get_shared_realm(config)->enqueue_write(add_row(2), [&](std::exception_ptr) { second_called = true; });
+        }, [](std::exception_ptr) { throw std::runtime_error("completion"); }), "completion");
+
+        REQUIRE(second_called);
+        REQUIRE(table->size() == 2);
+
+        // The queue isn't left marked as being performed
+        bool third_called = false;
+        realm->enqueue_write(add_row(3), [&](std::exception_ptr) { third_called = true; });
+        REQUIRE(third_called);
+    }
+
+    SECTION("the calling thread hands off to a background thread after a few batches") {
+        const size_t batch_count = 10;
+        std::mutex mutex;
+        std::vector<std::thread::id> write_threads;
+        std::atomic<size_t> completed{0};
+        std::function<void (SharedRealm)> chained_write = [&](SharedRealm r) {
+            add_row(0)(r);
+            std::lock_guard<std::mutex> lock(mutex);
+            write_threads.push_back(std::this_thread::get_id());
+            // Each write queues the next one, so each is performed in its own batch
+            if (write_threads.size() < batch_count) {
+                Realm::get_shared_realm(config)->enqueue_write(chained_write, [&](std::exception_ptr) { ++completed; });
+            }
+        };
+        realm->enqueue_write(chained_write, [&](std::exception_ptr) { ++completed; });
+
+        while (completed != batch_count)
+            std::this_thread::yield();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        REQUIRE(write_threads.size() == batch_count);
+        REQUIRE(write_threads.front() == std::this_thread::get_id());
+        REQUIRE(write_threads.back() != std::this_thread::get_id());
+        realm->refresh();
+        REQUIRE(table->size() == batch_count);
+    }
+
+    SECTION("writes from several threads are all committed") {
+        std::atomic<size_t> completed{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&, i] {
+                auto r = Realm::get_shared_realm(config);
+                for (int j = 0; j < 25; ++j)
+                    r->enqueue_write(add_row(i * 25 + j), [&](std::exception_ptr) { ++completed; });
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(completed == 100);
+        realm->refresh();
+        REQUIRE(table->size() == 100);
+    }
+
+    SECTION("is disallowed within a write transaction") {
+        realm->begin_transaction();
+        REQUIRE_THROWS(realm->enqueue_write(add_row(1)));
+        realm->cancel_transaction();
+    }
+}
+
+TEST_CASE("SharedRealm: async_write()") {
+    TestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.schema_version = 0;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int, "", "", false, false, false}
+        }},
+    };
+
+    auto realm = Realm::get_shared_realm(config);
+    auto table = realm->read_group().get_table("class_object");
+
+    auto notify_until = [&](auto&& predicate) {
+        while (!predicate()) {
+            realm->notify();
+            std::this_thread::yield();
+        }
+    };
+
+    SECTION("performs the write off the calling thread and calls the completion from notify()") {
+        std::thread::id writer_thread;
+        bool called = false;
+        realm->async_write([&](SharedRealm r) {
+            writer_thread = std::this_thread::get_id();
+            auto table = r->read_group().get_table("class_object");
+            table->set_int(0, table->add_empty_row(), 5);
+        }, [&](std::exception_ptr error) {
+            REQUIRE_FALSE(error);
+            called = true;
+        });
+
+        notify_until([&] { return called; });
+        REQUIRE(writer_thread != std::this_thread::get_id());
+        REQUIRE(table->size() == 1);
+        REQUIRE(table->get_int(0, 0) == 5);
+    }
+
+    SECTION("does not block on a write transaction held by the calling thread") {
+        realm->begin_transaction();
+        bool called = false;
+        realm->async_write([](SharedRealm r) {
+            r->read_group().get_table("class_object")->add_empty_row();
+        }, [&](std::exception_ptr) { called = true; });
+        table->add_empty_row();
+        realm->commit_transaction();
+
+        notify_until([&] { return called; });
+        REQUIRE(table->size() == 2);
+    }
+
+    SECTION("performs every write on the same background writer thread") {
+        std::vector<std::thread::id> writer_threads;
+        size_t called = 0;
+        for (int i = 0; i < 3; ++i) {
+            realm->async_write([&](SharedRealm r) {
+                writer_threads.push_back(std::this_thread::get_id());
+                r->read_group().get_table("class_object")->add_empty_row();
+            }, [&](std::exception_ptr) { ++called; });
+            // Wait for each to finish so that each is handed off separately
+            notify_until([&] { return called == size_t(i + 1); });
+        }
+
+        REQUIRE(writer_threads.size() == 3);
+        REQUIRE(writer_threads[0] != std::this_thread::get_id());
+        REQUIRE(writer_threads[1] == writer_threads[0]);
+        REQUIRE(writer_threads[2] == writer_threads[0]);
+    }
+
+    SECTION("finishes writes handed off before the last Realm is closed") {
+        realm->async_write([](SharedRealm r) {
+            r->read_group().get_table("class_object")->add_empty_row();
+        });
+        table = nullptr;
+        realm = nullptr;
+
+        // The writer thread keeps the coordinator alive until it commits
+        while (Realm::get_shared_realm(config)->read_group().get_table("class_object")->size() == 0)
+            std::this_thread::yield();
+    }
+
+    SECTION("reports errors thrown by the write") {
+        std::exception_ptr error;
+        realm->async_write([](SharedRealm) { throw std::runtime_error("fail"); },
+                           [&](std::exception_ptr e) { error = e; });
+        notify_until([&] { return !!error; });
+        REQUIRE_THROWS_WITH(std::rethrow_exception(error), "fail");
+        REQUIRE(table->size() == 0);
+    }
+}
+
+TEST_CASE("SharedRealm: deferred durability") {
+    TestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.durability = Realm::Config::Durability::Deferred;
+    config.schema_version = 0;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int, "", "", false, false, false}
+        }},
+    };
+
+    auto add_object = [](SharedRealm const& realm, int64_t value) {
+        realm->begin_transaction();
+        auto table = realm->read_group().get_table("class_object");
+        table->set_int(0, table->add_empty_row(), value);
+        realm->commit_transaction();
+    };
+
+    SECTION("commits are visible to other instances without flushing") {
+        auto realm = Realm::get_shared_realm(config);
+        auto realm2 = Realm::get_shared_realm(config);
+        auto table2 = realm2->read_group().get_table("class_object");
+        add_object(realm, 5);
+        realm2->refresh();
+        REQUIRE(table2->size() == 1);
+        REQUIRE(table2->get_int(0, 0) == 5);
+    }
+
+    SECTION("flush() can be called with or without pending commits") {
+        auto realm = Realm::get_shared_realm(config);
+        REQUIRE_NOTHROW(realm->flush());
+        add_object(realm, 1);
+        REQUIRE_NOTHROW(realm->flush());
+    }
+
+    SECTION("flush() does nothing on a closed Realm") {
+        auto realm = Realm::get_shared_realm(config);
+        add_object(realm, 1);
+        realm->close();
+        REQUIRE_NOTHROW(realm->flush());
+    }
+
+    SECTION("flush() can be called from a thread other than the Realm's") {
+        auto realm = Realm::get_shared_realm(config);
+        add_object(realm, 1);
+        std::thread([&] { REQUIRE_NOTHROW(realm->flush()); }).join();
+    }
+
+    SECTION("commits trigger flushes according to the flush policy") {
+        config.flush_after_commits = 2;
+        config.flush_interval = std::chrono::milliseconds(1);
+        auto realm = Realm::get_shared_realm(config);
+        for (int i = 0; i < 5; ++i) {
+            add_object(realm, i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(realm->read_group().get_table("class_object")->size() == 5);
+    }
+
+    SECTION("committed data is kept after the file is closed") {
+        {
+            auto realm = Realm::get_shared_realm(config);
+            add_object(realm, 7);
+        }
+        config.durability = Realm::Config::Durability::Full;
+        auto realm = Realm::get_shared_realm(config);
+        auto table = realm->read_group().get_table("class_object");
+        REQUIRE(table->size() == 1);
+        REQUIRE(table->get_int(0, 0) == 7);
+    }
+}
+
+TEST_CASE("SharedRealm: compaction") {
+    TestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.schema_version = 0;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::String, "", "", false, false, false}
+        }},
+    };
+
+    auto realm = Realm::get_shared_realm(config);
+    auto table = realm->read_group().get_table("class_object");
+    realm->begin_transaction();
+    table->add_empty_row(1000);
+    for (size_t i = 0; i < 1000; ++i)
+        table->set_string(0, i, i % 2 ? "a value which is repeated a lot" : "another repeated value");
+    realm->commit_transaction();
+
+    SECTION("should_compact_on_launch_function is called with the file's size and usage") {
+        realm->begin_transaction();
+        table->clear();
+        realm->commit_transaction();
+        realm = nullptr;
+        table = {};
+
+        uint64_t total = 0, used = 0;
+        config.schema = util::none;
+        config.should_compact_on_launch_function = [&](uint64_t total_bytes, uint64_t used_bytes) {
+            total = total_bytes;
+            used = used_bytes;
+            return true;
+        };
+        auto size_before = util::File(config.path).get_size();
+        realm = Realm::get_shared_realm(config);
+        REQUIRE(total > 0);
+        REQUIRE(used <= total);
+        REQUIRE(util::File(config.path).get_size() <= size_before);
+    }
+
+    SECTION("should_compact_on_launch_function is only called when the file is first opened") {
+        realm = nullptr;
+        table = {};
+
+        size_t calls = 0;
+        config.schema = util::none;
+        config.should_compact_on_launch_function = [&](uint64_t, uint64_t) {
+            ++calls;
+            return false;
+        };
+        realm = Realm::get_shared_realm(config);
+        auto realm2 = Realm::get_shared_realm(config);
+        auto frozen = realm->freeze({});
+        frozen.resolve();
+        REQUIRE(calls == 1);
+    }
+}
+
+TEST_CASE("SharedRealm: write_copy_async()") {
+    TestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.schema_version = 0;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int, "", "", false, false, false}
+        }},
+    };
+
+    auto realm = Realm::get_shared_realm(config);
+    auto table = realm->read_group().get_table("class_object");
+    realm->begin_transaction();
+    table->add_empty_row(100);
+    realm->commit_transaction();
+
+    TestFile copy_config;
+    copy_config.cache = false;
+    copy_config.automatic_change_notifications = false;
+    util::File::try_remove(copy_config.path);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::exception_ptr error;
+    auto completion = [&](std::exception_ptr e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = e;
+        done = true;
+        cv.notify_one();
+    };
+    auto wait = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return done; });
+    };
+
+    SECTION("writes the version which was current when it was called") {
+        std::atomic<uint64_t> written{0};
+        Realm::WriteCopyOptions options;
+        options.progress = [&](uint64_t bytes, uint64_t total) {
+            REQUIRE(bytes <= total);
+            written = bytes;
+        };
+        realm->write_copy_async(copy_config.path, BinaryData(), options, completion);
+
+        realm->begin_transaction();
+        table->add_empty_row(100);
+        realm->commit_transaction();
+
+        wait();
+        REQUIRE_FALSE(error);
+        REQUIRE(written > 0);
+
+        auto copy = Realm::get_shared_realm(copy_config);
+        REQUIRE(copy->read_group().get_table("class_object")->size() == 100);
+    }
+
+    SECTION("can be cancelled") {
+        Realm::WriteCopyOptions options;
+        options.should_cancel = [] { return true; };
+        realm->write_copy_async(copy_config.path, BinaryData(), options, completion);
+        wait();
+        REQUIRE_THROWS_AS(std::rethrow_exception(error), WriteCopyCancelledException);
+        REQUIRE_FALSE(util::File::exists(copy_config.path));
+    }
+
+    SECTION("closing the last Realm for the file cancels the copy rather than waiting for it") {
+        Realm::WriteCopyOptions options;
+        // Slow enough that waiting for the copy would time the test out
+        options.max_bytes_per_second = 1;
+        realm->write_copy_async(copy_config.path, BinaryData(), options, completion);
+        table = nullptr;
+        realm = nullptr;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        REQUIRE(done);
+        REQUIRE_THROWS_AS(std::rethrow_exception(error), WriteCopyCancelledException);
+        REQUIRE_FALSE(util::File::exists(copy_config.path));
+    }
+
+    SECTION("reports an error if the file already exists") {
+        realm->write_copy_async(config.path, BinaryData(), {}, completion);
+        wait();
+        REQUIRE_THROWS_AS(std::rethrow_exception(error), RealmFileException);
+    }
+}
@@ -31,6 +31,8 @@
 #include <realm/link_view.hpp>
 #include <realm/query_engine.hpp>
 
+#include <atomic>
+
 #include <unistd.h>
 
 using namespace realm;
@@ -163,6 +165,191 @@ TEST_CASE("results: notifications") {
             REQUIRE(called);
         }
 
+        SECTION("removing callbacks does not affect the other callbacks registered") {
+            std::vector<NotificationToken> tokens(100);
+            std::vector<int> calls(tokens.size());
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                tokens[i] = results.add_notification_callback([&, i](CollectionChangeSet, std::exception_ptr) {
+                    ++calls[i];
+                });
+            }
+            advance_and_notify(*r);
+
+            for (size_t i = 0; i < tokens.size(); i += 2)
+                tokens[i] = {};
+            write([&] {
+                table->set_int(0, 0, 4);
+            });
+
+            for (size_t i = 0; i < tokens.size(); ++i)
+                REQUIRE(calls[i] == (i % 2 ? 2 : 1));
+        }
+
+        SECTION("a callback added after the last one was removed is still called") {
+            NotificationToken token2 = results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) { });
+            advance_and_notify(*r);
+            token2 = {};
+
+            int calls = 0;
+            NotificationToken token3 = results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) {
+                ++calls;
+            });
+            advance_and_notify(*r);
+            REQUIRE(calls == 1);
+
+            write([&] {
+                table->set_int(0, 0, 4);
+            });
+            REQUIRE(calls == 2);
+        }
+
+        SECTION("key path filtered callbacks") {
+            auto linked_to = r->read_group().get_table("class_linked to object");
+            r->begin_transaction();
+            linked_to->add_empty_row();
+            table->set_link(1, 1, 0);
+            r->commit_transaction();
+            advance_and_notify(*r);
+
+            int value_calls = 0, link_calls = 0;
+            CollectionChangeSet value_change, link_change;
+            NotificationToken value_token, link_token;
+
+            SECTION("are only notified of modifications to the requested properties") {
+                token = {};
+                value_token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+                    value_change = c;
+                    ++value_calls;
+                }, {"value"});
+                advance_and_notify(*r);
+                REQUIRE(value_calls == 1);
+
+                write([&] {
+                    linked_to->set_int(0, 0, 5);
+                });
+                REQUIRE(value_calls == 1);
+
+                write([&] {
+                    table->set_int(0, 1, 3);
+                });
+                REQUIRE(value_calls == 2);
+                REQUIRE_INDICES(value_change.modifications, 0);
+            }
+
+            SECTION("follow links only through the requested properties") {
+                token = {};
+                link_token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+                    link_change = c;
+                    ++link_calls;
+                }, {"link.value"});
+                advance_and_notify(*r);
+                REQUIRE(link_calls == 1);
+
+                write([&] {
+                    table->set_int(0, 1, 3);
+                });
+                REQUIRE(link_calls == 1);
+
+                write([&] {
+                    linked_to->set_int(0, 0, 5);
+                });
+                REQUIRE(link_calls == 2);
+                REQUIRE_INDICES(link_change.modifications, 0);
+            }
+
+            SECTION("still report insertions and deletions") {
+                token = {};
+                link_token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+                    link_change = c;
+                    ++link_calls;
+                }, {"link"});
+                advance_and_notify(*r);
+
+                write([&] {
+                    table->set_int(0, 1, 0);
+                });
+                REQUIRE(link_calls == 2);
+                REQUIRE_INDICES(link_change.deletions, 0);
+            }
+
+            SECTION("are notified of all changes if another callback is not filtered") {
+                link_token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+                    link_change = c;
+                    ++link_calls;
+                }, {"link"});
+                advance_and_notify(*r);
+                REQUIRE(link_calls == 1);
+
+                write([&] {
+                    table->set_int(0, 1, 3);
+                });
+                REQUIRE(link_calls == 2);
+            }
+
+            SECTION("throw for properties which do not exist") {
+                REQUIRE_THROWS_AS(results.add_notification_callback([](CollectionChangeSet, std::exception_ptr) { }, {"nonexistent"}),
+                                  InvalidKeyPathException);
+            }
+        }
+
+        SECTION("callbacks of each priority are all notified") {
+            Results background_results(r, table->where().less(0, 4));
+            Results idle_results(r, table->where().greater(0, 4));
+            int visible_calls = 0, background_calls = 0, idle_calls = 0;
+            CollectionChangeSet visible_change;
+
+            auto visible_token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+                visible_change = c;
+                ++visible_calls;
+            }, {}, NotificationPriority::Visible);
+            auto background_token = background_results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) {
+                ++background_calls;
+            });
+            auto idle_token = idle_results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) {
+                ++idle_calls;
+            }, {}, NotificationPriority::Idle);
+            advance_and_notify(*r);
+            REQUIRE(visible_calls == 1);
+            REQUIRE(background_calls == 1);
+            REQUIRE(idle_calls == 1);
+
+            write([&] {
+                table->set_int(0, 1, 3);
+                table->set_int(0, 0, 1);
+                table->set_int(0, 9, 5);
+            });
+            REQUIRE(visible_calls == 2);
+            REQUIRE_INDICES(visible_change.modifications, 0);
+            REQUIRE(background_calls == 2);
+            REQUIRE(idle_calls == 2);
+        }
+
+        SECTION("visible callbacks in a Realm with no other notifiers are notified") {
+            auto r2 = Realm::get_shared_realm(config);
+            Results visible_results(r2, r2->read_group().get_table("class_object")->where().greater(0, 0).less(0, 10));
+            Results background_results(r, table->where().less(0, 4));
+            int visible_calls = 0, background_calls = 0;
+
+            auto visible_token = visible_results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) {
+                ++visible_calls;
+            }, {}, NotificationPriority::Visible);
+            auto background_token = background_results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) {
+                ++background_calls;
+            });
+            advance_and_notify(*r);
+            advance_and_notify(*r2);
+            REQUIRE(visible_calls == 1);
+            REQUIRE(background_calls == 1);
+
+            write([&] {
+                table->set_int(0, 1, 3);
+                table->set_int(0, 0, 1);
+            });
+            advance_and_notify(*r2);
+            REQUIRE(visible_calls == 2);
+            REQUIRE(background_calls == 2);
+        }
+
         SECTION("modifications to unrelated tables do not send notifications") {
             write([&] {
                 r->read_group().get_table("class_other object")->add_empty_row();
@@ -1097,3 +1284,204 @@ TEST_CASE("results: snapshots") {
         CHECK_THROWS(snapshot.add_notification_callback([](CollectionChangeSet, std::exception_ptr) {}));
     }
 }
+
+TEST_CASE("results: parallel_for_each") {
+    InMemoryTestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int},
+        }},
+    };
+
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_object");
+
+    r->begin_transaction();
+    for (int i = 0; i < 1000; ++i)
+        table->set_int(0, table->add_empty_row(), i);
+    r->commit_transaction();
+
+    Results results(r, table->where().greater_equal(0, 100));
+    results = results.sort({*table, {{0}}, {false}});
+
+    SECTION("visits every row exactly once with the index it has in the Results") {
+        std::vector<std::atomic<int>> seen(900);
+        for (auto& count : seen)
+            count = 0;
+        std::atomic<int> mismatches{0};
+
+        results.parallel_for_each(4, [&](size_t ndx, RowExpr row) {
+            if (row.get_int(0) != int64_t(999 - ndx))
+                ++mismatches;
+            ++seen[ndx];
+        });
+        REQUIRE(mismatches == 0);
+        for (auto& count : seen)
+            REQUIRE(count == 1);
+    }
+
+    SECTION("reads every value") {
+        std::atomic<int64_t> sum{0};
+        results.parallel_for_each(3, [&](size_t, RowExpr row) {
+            sum += row.get_int(0);
+        });
+        REQUIRE(sum == (100 + 999) * 900 / 2);
+    }
+
+    SECTION("gives each index the same row as the Results even when the sort has ties") {
+        r->begin_transaction();
+        table->add_column(type_Int, "bucket");
+        for (size_t i = 0; i < table->size(); ++i)
+            table->set_int(1, i, i % 3);
+        r->commit_transaction();
+
+        auto tied = Results(r, table->where()).sort({*table, {{1}}, {true}});
+        std::vector<size_t> rows(tied.size());
+        tied.parallel_for_each(4, [&](size_t ndx, RowExpr row) {
+            rows[ndx] = row.get_index();
+        });
+        for (size_t i = 0; i < rows.size(); ++i)
+            REQUIRE(rows[i] == tied.get(i).get_index());
+    }
+
+    SECTION("handles more partitions than rows") {
+        std::atomic<size_t> count{0};
+        Results(r, table->where().equal(0, 5)).parallel_for_each(8, [&](size_t, RowExpr) {
+            ++count;
+        });
+        REQUIRE(count == 1);
+    }
+
+    SECTION("rethrows exceptions thrown by the callback") {
+        REQUIRE_THROWS_WITH(results.parallel_for_each(4, [&](size_t ndx, RowExpr) {
+            if (ndx == 500)
+                throw std::runtime_error("failed");
+        }), "failed");
+    }
+
+    SECTION("processes snapshots, including rows deleted since they were taken") {
+        auto snapshot = results.snapshot();
+        r->begin_transaction();
+        table->move_last_over(table->find_first_int(0, 100));
+        r->commit_transaction();
+
+        std::atomic<size_t> count{0};
+        std::atomic<size_t> detached{0};
+        std::atomic<int> mismatches{0};
+        snapshot.parallel_for_each(4, [&](size_t ndx, RowExpr row) {
+            ++count;
+            if (!row.is_attached())
+                ++detached;
+            else if (row.get_int(0) != int64_t(999 - ndx))
+                ++mismatches;
+        });
+        REQUIRE(count == 900);
+        REQUIRE(detached == 1);
+        REQUIRE(mismatches == 0);
+    }
+
+    SECTION("is disallowed in write transactions") {
+        r->begin_transaction();
+        REQUIRE_THROWS(results.parallel_for_each(2, [](size_t, RowExpr) {}));
+        r->cancel_transaction();
+    }
+}
+
+TEST_CASE("results: index_of") {
+    InMemoryTestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int},
+        }},
+    };
+
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_object");
+
+    r->begin_transaction();
+    for (int i = 0; i < 100; ++i)
+        table->set_int(0, table->add_empty_row(), i);
+    r->commit_transaction();
+
+    Results results(r, table->where().greater_equal(0, 50));
+    results = results.sort({*table, {{0}}, {false}});
+
+    auto require_positions = [&](Results& results) {
+        for (size_t i = 0; i < results.size(); ++i)
+            REQUIRE(results.index_of(results.get(i).get_index()) == i);
+    };
+
+    SECTION("repeated lookups return the same positions as a scan") {
+        require_positions(results);
+        require_positions(results);
+        REQUIRE(results.index_of(size_t(0)) == not_found);
+    }
+
+    SECTION("positions are updated after a write") {
+        require_positions(results);
+        r->begin_transaction();
+        table->set_int(0, 99, 0);
+        table->move_last_over(60);
+        r->commit_transaction();
+        require_positions(results);
+        REQUIRE(results.index_of(size_t(60)) == not_found);
+    }
+
+    SECTION("positions are updated within a write transaction") {
+        require_positions(results);
+        r->begin_transaction();
+        table->set_int(0, table->add_empty_row(), 1000);
+        REQUIRE(results.index_of(size_t(100)) == 0);
+        require_positions(results);
+        r->cancel_transaction();
+        require_positions(results);
+    }
+
+    SECTION("copies build their own index") {
+        require_positions(results);
+        require_positions(results);
+        Results copy(results);
+        require_positions(copy);
+        r->begin_transaction();
+        table->move_last_over(99);
+        r->commit_transaction();
+        copy = results;
+        require_positions(copy);
+        require_positions(results);
+        REQUIRE(copy.index_of(size_t(99)) == not_found);
+    }
+
+    SECTION("snapshots") {
+        auto snapshot = results.snapshot();
+        require_positions(snapshot);
+        r->begin_transaction();
+        table->move_last_over(99);
+        r->commit_transaction();
+        REQUIRE(snapshot.index_of(size_t(99)) == not_found);
+        REQUIRE(snapshot.index_of(size_t(98)) == 1);
+    }
+
+    SECTION("linkview") {
+        r->begin_transaction();
+        r->read_group().add_table("class_linking")->add_column_link(type_LinkList, "list", *table);
+        auto origin = r->read_group().get_table("class_linking");
+        origin->add_empty_row();
+        auto lv = origin->get_linklist(0, 0);
+        for (size_t i = 0; i < 50; ++i)
+            lv->add(49 - i);
+        r->commit_transaction();
+
+        Results results(r, lv);
+        require_positions(results);
+        require_positions(results);
+        r->begin_transaction();
+        lv->remove(0);
+        r->commit_transaction();
+        require_positions(results);
+        REQUIRE(results.index_of(size_t(49)) == not_found);
+    }
+}
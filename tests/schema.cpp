@@ -473,4 +473,40 @@ TEST_CASE("Schema") {
                 &schema2.find("object")->persisted_properties[0]})});
         }
     }
+
+    SECTION("fingerprint()") {
+        Schema schema = {
+            {"object", {
+                {"value", PropertyType::Int, "", "", false, false, false},
+                {"link", PropertyType::Object, "object", "", false, false, true},
+            }},
+        };
+
+        SECTION("is the same for identical schemas") {
+            Schema schema2 = schema;
+            REQUIRE(schema.fingerprint() == schema2.fingerprint());
+        }
+
+        SECTION("ignores column indexes and computed properties") {
+            Schema schema2 = schema;
+            schema2.find("object")->persisted_properties[0].table_column = 5;
+            schema2.find("object")->computed_properties.push_back({"origins", PropertyType::LinkingObjects, "object", "link"});
+            REQUIRE(schema.fingerprint() == schema2.fingerprint());
+        }
+
+        SECTION("changes when the file layout changes") {
+            auto fingerprint = schema.fingerprint();
+            auto modify = [&](auto&& fn) {
+                Schema schema2 = schema;
+                fn(*schema2.find("object"));
+                return schema2.fingerprint();
+            };
+            REQUIRE(modify([](auto& os) { os.persisted_properties[0].type = PropertyType::Double; }) != fingerprint);
+            REQUIRE(modify([](auto& os) { os.persisted_properties[0].is_nullable = true; }) != fingerprint);
+            REQUIRE(modify([](auto& os) { os.persisted_properties[0].is_indexed = true; }) != fingerprint);
+            REQUIRE(modify([](auto& os) { os.persisted_properties[0].name = "value2"; }) != fingerprint);
+            REQUIRE(modify([](auto& os) { os.persisted_properties[1].object_type = "object2"; }) != fingerprint);
+            REQUIRE(modify([](auto& os) { os.name = "object2"; }) != fingerprint);
+        }
+    }
 }
@@ -1963,3 +1963,146 @@ TEST_CASE("DeepChangeChecker") {
         REQUIRE(_impl::DeepChangeChecker(info, *table, tables)(0));
     }
 }
+
+TEST_CASE("Transaction log parsing: replaying a recording") {
+    InMemoryTestFile config;
+    config.automatic_change_notifications = false;
+
+    auto r = Realm::get_shared_realm(config);
+    r->update_schema({
+        {"table", {
+            {"value", PropertyType::Int},
+        }},
+    });
+    auto& table = *r->read_group().get_table("class_table");
+    size_t table_ndx = table.get_index_in_group();
+
+    r->begin_transaction();
+    table.add_empty_row(10);
+    r->commit_transaction();
+
+    auto history = make_in_realm_history(config.path);
+    SharedGroup recorder(*history, config.options());
+    recorder.begin_read();
+
+    auto history2 = make_in_realm_history(config.path);
+    SharedGroup replayer(*history2, config.options());
+    replayer.begin_read();
+
+    auto record = [&](auto&& fn) {
+        r->begin_transaction();
+        fn();
+        r->commit_transaction();
+
+        _impl::TransactionChangeInfo info;
+        _impl::TransactLogRecording recording;
+        _impl::transaction::advance(recorder, info, {}, &recording);
+        return recording;
+    };
+
+    struct Context : BindingContext {
+        std::vector<ObserverState> observed;
+        std::vector<ObserverState> changed;
+        std::vector<void*> invalidated;
+
+        std::vector<ObserverState> get_observed_rows() override { return observed; }
+        void did_change(std::vector<ObserverState> const& observers,
+                        std::vector<void*> const& invalidated) override
+        {
+            changed = observers;
+            this->invalidated = invalidated;
+        }
+    } context;
+    int row_info;
+    context.observed.push_back({table_ndx, 5, &row_info});
+
+    SECTION("modifications are reported to the context") {
+        auto recording = record([&] { table.set_int(0, 5, 1); });
+        REQUIRE_FALSE(recording.instructions.empty());
+
+        _impl::transaction::advance(replayer, &context, SchemaMode::Automatic,
+                                    recorder.get_version_of_current_transaction(), &recording);
+        REQUIRE(replayer.get_version_of_current_transaction() == recorder.get_version_of_current_transaction());
+        REQUIRE(context.changed.size() == 1);
+        REQUIRE(context.changed[0].changes.size() >= 1);
+        REQUIRE(context.changed[0].changes[0].kind == BindingContext::ColumnInfo::Kind::Set);
+    }
+
+    SECTION("row moves and deletions are reported to the context") {
+        auto recording = record([&] {
+            table.move_last_over(0);
+            table.move_last_over(5);
+        });
+
+        _impl::transaction::advance(replayer, &context, SchemaMode::Automatic,
+                                    recorder.get_version_of_current_transaction(), &recording);
+        REQUIRE(context.changed.empty());
+        REQUIRE(context.invalidated.size() == 1);
+        REQUIRE(context.invalidated[0] == &row_info);
+    }
+
+    SECTION("schema changes are validated") {
+        auto recording = record([&] { table.add_column(type_String, "new col"); });
+        REQUIRE_THROWS(_impl::transaction::advance(replayer, nullptr, SchemaMode::Automatic,
+                                                   recorder.get_version_of_current_transaction(),
+                                                   &recording));
+    }
+
+    SECTION("row-level changes are not included in the schema instructions") {
+        auto recording = record([&] {
+            table.set_int(0, 5, 1);
+            table.add_empty_row();
+        });
+        REQUIRE_FALSE(recording.instructions.empty());
+        REQUIRE(recording.schema_instructions.empty());
+
+        REQUIRE_NOTHROW(_impl::transaction::advance(replayer, nullptr, SchemaMode::Automatic,
+                                                    recorder.get_version_of_current_transaction(),
+                                                    &recording));
+        REQUIRE(replayer.get_version_of_current_transaction() == recorder.get_version_of_current_transaction());
+    }
+
+    SECTION("schema changes are validated even if the recording overflowed") {
+        auto recording = record([&] {
+            for (int i = 0; i <= 100000; ++i)
+                table.set_int(0, i % 10, i);
+            table.add_column(type_String, "new col");
+        });
+        REQUIRE(recording.overflowed);
+        REQUIRE(recording.instructions.empty());
+        REQUIRE_FALSE(recording.schema_instructions.empty());
+
+        REQUIRE_THROWS(_impl::transaction::advance(replayer, nullptr, SchemaMode::Automatic,
+                                                   recorder.get_version_of_current_transaction(),
+                                                   &recording));
+    }
+
+    SECTION("schema instructions stop being recorded past the size limit") {
+        _impl::TransactLogRecording recording;
+        for (size_t i = 0; i <= 100000; ++i)
+            recording.add(_impl::TransactLogRecording::Type::InsertColumn, i);
+        REQUIRE(recording.schema_overflowed);
+        REQUIRE(recording.schema_instructions.empty());
+    }
+
+    SECTION("schema changes are validated by parsing the log if the schema instructions overflowed") {
+        auto recording = record([&] { table.add_column(type_String, "new col"); });
+        recording.schema_overflowed = true;
+        recording.schema_instructions.clear();
+
+        REQUIRE_THROWS(_impl::transaction::advance(replayer, nullptr, SchemaMode::Automatic,
+                                                   recorder.get_version_of_current_transaction(),
+                                                   &recording));
+    }
+
+    SECTION("an overflowed recording falls back to parsing the transaction log") {
+        auto recording = record([&] { table.set_int(0, 5, 1); });
+        recording.overflowed = true;
+        recording.instructions.clear();
+
+        _impl::transaction::advance(replayer, &context, SchemaMode::Automatic,
+                                    recorder.get_version_of_current_transaction(), &recording);
+        REQUIRE(context.changed.size() == 1);
+        REQUIRE(context.changed[0].changes[0].kind == BindingContext::ColumnInfo::Kind::Set);
+    }
+}